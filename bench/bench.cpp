@@ -0,0 +1,1107 @@
+#include "scumECS/ECS.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// benchmarks the core operations of the library over a range of entity
+// counts and writes the results as JSON.
+//
+// usage: scumECS_bench [--max N] [--filter TEXT] [--out PATH] [--counters]
+//   --max       the largest entity count to run (default 1000000)
+//   --filter    only run scenarios whose name contains TEXT
+//   --out       write the JSON to PATH instead of stdout
+//   --counters  also count cycles, instructions, cache misses, and branch
+//               misses per operation with perf_event_open. Linux only, and
+//               needs kernel.perf_event_paranoid <= 2. counters which can't
+//               be opened are reported as null
+//
+// scenarios which go through a Manager are limited to 1,000,000 entities,
+// since that is about the most IDs a manager can hand out at once (see
+// Manager::newID). the "pool." scenarios use a Pool directly with IDs
+// spaced out like a manager's, or with plain sequential IDs past that limit.
+// the "frames." scenarios run a game loop for 1000 frames and report
+// percentiles of the frame times instead of an average, along with which
+// frames grew a pool's arrays or lookup table, under "frames" in the JSON.
+//
+// scumECS_bench uses the default lookup table in pools. scumECS_bench_std,
+// scumECS_bench_sparse, and scumECS_bench_flat are built from the same
+// source with the other SCUM_LOOKUP_BACKEND choices, for comparing them.
+// the sparse backend needs every ID in a pool to have its own slot, so it
+// skips the pool scenarios past the manager limit.
+
+struct Position
+{
+	float x;
+	float y;
+	float z;
+};
+
+struct Velocity
+{
+	float x;
+	float y;
+	float z;
+};
+
+struct Health
+{
+	int value;
+};
+
+struct Tag
+{
+	uint32_t flags;
+};
+
+namespace
+{
+
+const size_t managerLimit = 1000000;
+// IDs resolved per call in the getMany scenarios, as a system working
+// through a list of targets in chunks would
+const size_t batchSize = 256;
+
+// stops the compiler from optimizing away the work being measured
+volatile uint64_t sink;
+
+// hardware events counted for this process in user space while enabled.
+// each event has its own counter, so one the CPU or kernel doesn't support
+// is left out without losing the rest
+class Counters
+{
+public:
+	static const size_t Count = 5;
+	static constexpr const char* names[Count] = {"cycles", "instructions",
+		"l1d_misses", "llc_misses", "branch_misses"};
+
+	Counters();
+	Counters(const Counters&) = delete;
+	Counters& operator=(const Counters&) = delete;
+	~Counters();
+
+	bool any() const;
+	void reset();
+	void enable();
+	void disable();
+	void read(double totals[Count]) const;
+
+private:
+	int fds[Count];
+};
+
+#ifdef __linux__
+Counters::Counters()
+{
+	const uint32_t types[Count] = {PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+		PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE};
+	const uint64_t configs[Count] = {PERF_COUNT_HW_CPU_CYCLES,
+		PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_L1D |
+		(PERF_COUNT_HW_CACHE_OP_READ << 8) |
+		(PERF_COUNT_HW_CACHE_RESULT_MISS << 16), PERF_COUNT_HW_CACHE_MISSES,
+		PERF_COUNT_HW_BRANCH_MISSES};
+	for(size_t i = 0; i < Count; i++)
+	{
+		perf_event_attr attr{};
+		attr.size = sizeof(attr);
+		attr.type = types[i];
+		attr.config = configs[i];
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+			PERF_FORMAT_TOTAL_TIME_RUNNING;
+		fds[i] = int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+	}
+}
+
+Counters::~Counters()
+{
+	for(int fd : fds)
+	{
+		if(fd >= 0)
+		{
+			close(fd);
+		}
+	}
+}
+
+bool Counters::any() const
+{
+	return std::any_of(fds, fds + Count, [](int fd) { return fd >= 0; });
+}
+
+void Counters::reset()
+{
+	for(int fd : fds)
+	{
+		if(fd >= 0)
+		{
+			ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+		}
+	}
+}
+
+void Counters::enable()
+{
+	for(int fd : fds)
+	{
+		if(fd >= 0)
+		{
+			ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+		}
+	}
+}
+
+void Counters::disable()
+{
+	for(int fd : fds)
+	{
+		if(fd >= 0)
+		{
+			ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+		}
+	}
+}
+
+// gets the counts since the last reset, scaled up for any time the kernel
+// had to take a counter off the CPU to share it. NaN for counters which
+// couldn't be opened or read
+void Counters::read(double totals[Count]) const
+{
+	for(size_t i = 0; i < Count; i++)
+	{
+		uint64_t values[3]; // count, time enabled, time running
+		totals[i] = NAN;
+		if(fds[i] >= 0 && ::read(fds[i], values, sizeof(values)) ==
+			ssize_t(sizeof(values)) && values[2] != 0)
+		{
+			totals[i] = double(values[0]) * values[1] / values[2];
+		}
+	}
+}
+#else
+Counters::Counters()
+{
+	std::fill(fds, fds + Count, -1);
+}
+
+Counters::~Counters() = default;
+bool Counters::any() const { return false; }
+void Counters::reset() {}
+void Counters::enable() {}
+void Counters::disable() {}
+
+void Counters::read(double totals[Count]) const
+{
+	std::fill(totals, totals + Count, NAN);
+}
+#endif
+
+struct Result
+{
+	std::string name;
+	size_t entities;
+	size_t ops;
+	size_t runs;
+	double nsPerOp; // median over runs
+	double minNsPerOp;
+	// mean hardware events per operation over every run, or NaN if they
+	// weren't counted
+	double countersPerOp[Counters::Count];
+};
+
+// times the part of a run between start() and stop(), and counts hardware
+// events over the same part if given counters. the counters are switched
+// outside of the timed part, so counting doesn't add to the times
+class Timer
+{
+public:
+	explicit Timer(Counters* counters = nullptr)
+		: counters(counters)
+	{}
+
+	void start()
+	{
+		if(counters != nullptr)
+		{
+			counters->enable();
+		}
+		begin = std::chrono::steady_clock::now();
+	}
+	void stop()
+	{
+		elapsed += std::chrono::steady_clock::now() - begin;
+		if(counters != nullptr)
+		{
+			counters->disable();
+		}
+	}
+	double nanoseconds() const
+	{
+		return std::chrono::duration<double, std::nano>(elapsed).count();
+	}
+
+private:
+	Counters* counters;
+	std::chrono::steady_clock::time_point begin;
+	std::chrono::steady_clock::duration elapsed{};
+};
+
+struct Frame
+{
+	size_t index;
+	double nanoseconds;
+	bool reallocated; // a pool's or the manager's arrays grew
+	bool rehashed; // a pool's lookup table grew
+	bool allocated; // the manager allocated memory at all
+};
+
+struct FrameResult
+{
+	std::string name;
+	size_t entities = 0;
+	size_t frames = 0;
+	double p50 = 0;
+	double p99 = 0;
+	double p999 = 0;
+	double max = 0;
+	size_t reallocatedFrames = 0;
+	size_t rehashedFrames = 0;
+	size_t allocatedFrames = 0;
+	double maxGrowthNs = 0; // the slowest frame which grew something
+	double maxSteadyNs = 0; // the slowest frame which didn't
+	std::vector<Frame> slowest{}; // the slowest few frames, slowest first
+};
+
+// times each frame of a game loop and notes which frames grew a pool's
+// arrays or lookup table, since those are what make the worst frames. the
+// manager's stats are compared after each frame, outside of the timed part,
+// and its memory resource counts any other allocations
+class FrameTimer
+{
+public:
+	FrameTimer(const scum::Manager& manager,
+		const scum::CountingResource& counter)
+		: manager(manager), counter(counter)
+	{}
+
+	// setup before the first frame isn't counted as growth
+	void start()
+	{
+		if(frames.empty())
+		{
+			last = capacities();
+		}
+		allocations = counter.allocations();
+		begin = std::chrono::steady_clock::now();
+	}
+	void stop()
+	{
+		double ns = std::chrono::duration<double, std::nano>
+			(std::chrono::steady_clock::now() - begin).count();
+		Capacities now = capacities();
+		bool rehashed = now.buckets != last.buckets;
+		frames.push_back(Frame{frames.size(), ns, now.arrays != last.arrays,
+			rehashed, counter.allocations() != allocations});
+		last = std::move(now);
+	}
+
+	std::vector<Frame> frames;
+
+private:
+	// the capacity of each pool's arrays and lookup table, in pool order
+	struct Capacities
+	{
+		std::vector<size_t> arrays;
+		std::vector<size_t> buckets;
+	};
+
+	Capacities capacities() const
+	{
+		auto stats = manager.stats();
+		Capacities result;
+		for(auto& pool : stats.pools)
+		{
+			result.arrays.push_back(pool.componentBytes + pool.entityBytes +
+				pool.queueBytes);
+			result.buckets.push_back(pool.lookupBuckets);
+		}
+		result.arrays.push_back(stats.managerBytes);
+		return result;
+	}
+
+	const scum::Manager& manager;
+	const scum::CountingResource& counter;
+	size_t allocations = 0; // the count when the frame started
+	Capacities last;
+	std::chrono::steady_clock::time_point begin;
+};
+
+class Harness
+{
+public:
+	Harness(size_t maxEntities, std::string filter, Counters* counters)
+		: maxEntities(maxEntities), filter(std::move(filter)),
+		counters(counters)
+	{}
+
+	// runs a scenario several times. fn does its own setup, calls
+	// timer.start() and timer.stop() around the work being measured, and
+	// performs ops operations in that time
+	template<typename Fn>
+	void run(const std::string& name, size_t entities, size_t ops, Fn fn)
+	{
+		if(name.find(filter) == std::string::npos || ops == 0)
+		{
+			return;
+		}
+		size_t runs = std::clamp<size_t>(2000000 / (entities + 1), 3, 20);
+		std::vector<double> samples;
+		if(counters != nullptr)
+		{
+			counters->reset();
+		}
+		for(size_t i = 0; i < runs; i++)
+		{
+			Timer timer(counters);
+			fn(timer);
+			samples.push_back(timer.nanoseconds() / ops);
+		}
+		std::sort(samples.begin(), samples.end());
+		Result result{name, entities, ops, runs, samples[samples.size() / 2],
+			samples.front(), {}};
+		std::fill(result.countersPerOp, result.countersPerOp + Counters::Count,
+			NAN);
+		if(counters != nullptr)
+		{
+			counters->read(result.countersPerOp);
+			for(double& count : result.countersPerOp)
+			{
+				count /= double(ops) * runs;
+			}
+		}
+		results.push_back(result);
+
+		std::fprintf(stderr, "%-24s %10zu entities %12.2f ns/op",
+			name.c_str(), entities, result.nsPerOp);
+		if(counters != nullptr)
+		{
+			// the misses are what matter most for iteration and searches
+			std::fprintf(stderr, " %8.2f L1D %8.2f LLC miss/op",
+				result.countersPerOp[2], result.countersPerOp[3]);
+		}
+		std::fprintf(stderr, "\n");
+	}
+
+	// runs a game loop scenario once. fn does its own setup and calls
+	// frames.start() and frames.stop() around each frame
+	template<typename Fn>
+	void runFrames(const std::string& name, size_t entities, Fn fn)
+	{
+		if(name.find(filter) == std::string::npos)
+		{
+			return;
+		}
+		scum::CountingResource counter;
+		scum::Manager manager(&counter);
+		FrameTimer timer(manager, counter);
+		fn(manager, timer);
+		if(timer.frames.empty())
+		{
+			return;
+		}
+
+		FrameResult result{name, entities, timer.frames.size()};
+		std::vector<double> times;
+		for(auto& frame : timer.frames)
+		{
+			times.push_back(frame.nanoseconds);
+			result.reallocatedFrames += frame.reallocated;
+			result.rehashedFrames += frame.rehashed;
+			result.allocatedFrames += frame.allocated;
+			double& max = frame.reallocated || frame.rehashed ?
+				result.maxGrowthNs : result.maxSteadyNs;
+			max = std::max(max, frame.nanoseconds);
+		}
+		std::sort(times.begin(), times.end());
+		auto percentile = [&](double p)
+		{
+			return times[std::min(times.size() - 1, size_t(p * times.size()))];
+		};
+		result.p50 = percentile(0.5);
+		result.p99 = percentile(0.99);
+		result.p999 = percentile(0.999);
+		result.max = times.back();
+		auto& slowest = timer.frames;
+		std::sort(slowest.begin(), slowest.end(), [](auto& l, auto& r)
+		{
+			return l.nanoseconds > r.nanoseconds;
+		});
+		slowest.resize(std::min<size_t>(slowest.size(), 5));
+		result.slowest = slowest;
+		frameResults.push_back(result);
+
+		std::fprintf(stderr, "%-24s %10zu entities  p50 %9.1f  p99 %9.1f  "
+			"p99.9 %9.1f  max %9.1f us  (%zu realloc, %zu rehash, %zu alloc "
+			"frames)\n", name.c_str(), entities, result.p50 / 1000,
+			result.p99 / 1000, result.p999 / 1000, result.max / 1000,
+			result.reallocatedFrames, result.rehashedFrames,
+			result.allocatedFrames);
+	}
+
+	bool writeJSON(std::FILE* out) const
+	{
+		std::fprintf(out, "{\n\t\"benchmark\": \"scumECS\",\n");
+		std::fprintf(out, "\t\"lookup\": \"%s\",\n", scum::lookupBackend());
+		std::fprintf(out, "\t\"results\": [");
+		for(size_t i = 0; i < results.size(); i++)
+		{
+			const Result& result = results[i];
+			std::fprintf(out, "%s\n\t\t{\"name\": \"%s\", \"entities\": %zu, "
+				"\"ops\": %zu, \"runs\": %zu, \"ns_per_op\": %.3f, "
+				"\"min_ns_per_op\": %.3f", i == 0 ? "" : ",",
+				result.name.c_str(), result.entities, result.ops, result.runs,
+				result.nsPerOp, result.minNsPerOp);
+			if(counters != nullptr)
+			{
+				for(size_t j = 0; j < Counters::Count; j++)
+				{
+					double count = result.countersPerOp[j];
+					if(std::isnan(count))
+					{
+						std::fprintf(out, ", \"%s_per_op\": null",
+							Counters::names[j]);
+					}
+					else
+					{
+						std::fprintf(out, ", \"%s_per_op\": %.4f",
+							Counters::names[j], count);
+					}
+				}
+			}
+			std::fprintf(out, "}");
+		}
+		std::fprintf(out, "\n\t],\n\t\"frames\": [");
+		for(size_t i = 0; i < frameResults.size(); i++)
+		{
+			const FrameResult& result = frameResults[i];
+			std::fprintf(out, "%s\n\t\t{\"name\": \"%s\", \"entities\": %zu, "
+				"\"frames\": %zu, \"p50_ns\": %.0f, \"p99_ns\": %.0f, "
+				"\"p999_ns\": %.0f, \"max_ns\": %.0f, \"realloc_frames\": %zu, "
+				"\"rehash_frames\": %zu, \"alloc_frames\": %zu, "
+				"\"max_growth_ns\": %.0f, \"max_steady_ns\": %.0f, "
+				"\"slowest\": [", i == 0 ? "" : ",", result.name.c_str(),
+				result.entities, result.frames, result.p50, result.p99,
+				result.p999, result.max, result.reallocatedFrames,
+				result.rehashedFrames, result.allocatedFrames, result.maxGrowthNs,
+				result.maxSteadyNs);
+			for(size_t j = 0; j < result.slowest.size(); j++)
+			{
+				const Frame& frame = result.slowest[j];
+				std::fprintf(out, "%s{\"frame\": %zu, \"ns\": %.0f, "
+					"\"realloc\": %s, \"rehash\": %s, \"alloc\": %s}",
+					j == 0 ? "" : ", ", frame.index, frame.nanoseconds,
+					frame.reallocated ? "true" : "false",
+					frame.rehashed ? "true" : "false",
+					frame.allocated ? "true" : "false");
+			}
+			std::fprintf(out, "]}");
+		}
+		std::fprintf(out, "\n\t]\n}\n");
+		return std::ferror(out) == 0;
+	}
+
+	const size_t maxEntities;
+
+private:
+	std::string filter;
+	Counters* counters; // null unless counting hardware events
+	std::vector<Result> results;
+	std::vector<FrameResult> frameResults;
+};
+
+// creates count entities. every entity has a Position, and every second,
+// fourth, and eighth has a Velocity, Health, and Tag
+std::vector<scum::ID> populate(scum::Manager& manager, size_t count)
+{
+	std::vector<scum::ID> ids;
+	ids.reserve(count);
+	for(size_t i = 0; i < count; i++)
+	{
+		auto id = manager.newID();
+		ids.push_back(id);
+		manager.add<Position>(id, float(i), 0.0f, 0.0f);
+		if(i % 2 == 0)
+		{
+			manager.add<Velocity>(id, 1.0f, 0.0f, 0.0f);
+		}
+		if(i % 4 == 0)
+		{
+			manager.add<Health>(id, 100);
+		}
+		if(i % 8 == 0)
+		{
+			manager.add<Tag>(id, uint32_t(i));
+		}
+	}
+	return ids;
+}
+
+template<typename T>
+std::vector<T> shuffled(std::vector<T> values, uint32_t seed = 1)
+{
+	std::mt19937 random(seed);
+	std::shuffle(values.begin(), values.end(), random);
+	return values;
+}
+
+template<typename... Cs>
+void runSearch(Harness& bench, const std::string& name, size_t n)
+{
+	bench.run(name, n, n, [&](Timer& timer)
+	{
+		scum::Manager manager;
+		populate(manager, n);
+		uint64_t found = 0;
+		timer.start();
+		for(auto id : manager.search<Cs...>())
+		{
+			found += id;
+		}
+		timer.stop();
+		sink = found;
+	});
+}
+
+void managerScenarios(Harness& bench, size_t n)
+{
+	bench.run("newID", n, n, [&](Timer& timer)
+	{
+		scum::Manager manager;
+		uint64_t total = 0;
+		timer.start();
+		for(size_t i = 0; i < n; i++)
+		{
+			total += manager.newID();
+		}
+		timer.stop();
+		sink = total;
+	});
+
+	bench.run("add", n, n, [&](Timer& timer)
+	{
+		scum::Manager manager;
+		std::vector<scum::ID> ids;
+		for(size_t i = 0; i < n; i++)
+		{
+			ids.push_back(manager.newID());
+		}
+		timer.start();
+		for(auto id : ids)
+		{
+			manager.add<Position>(id, 1.0f, 2.0f, 3.0f);
+		}
+		timer.stop();
+	});
+
+	bench.run("get", n, n, [&](Timer& timer)
+	{
+		scum::Manager manager;
+		auto ids = shuffled(populate(manager, n));
+		float total = 0.0f;
+		timer.start();
+		for(auto id : ids)
+		{
+			total += manager.get<Position>(id)->x;
+		}
+		timer.stop();
+		sink = uint64_t(total);
+	});
+
+	bench.run("getMany", n, n, [&](Timer& timer)
+	{
+		scum::Manager manager;
+		auto ids = shuffled(populate(manager, n));
+		std::vector<Position*> found(batchSize);
+		float total = 0.0f;
+		timer.start();
+		for(size_t i = 0; i < n; i += batchSize)
+		{
+			size_t count = std::min(batchSize, n - i);
+			manager.getMany<Position>(ids.data() + i, count, found.data());
+			for(size_t j = 0; j < count; j++)
+			{
+				total += found[j]->x;
+			}
+		}
+		timer.stop();
+		sink = uint64_t(total);
+	});
+
+	// half of the lookups miss
+	bench.run("tryGet", n, n, [&](Timer& timer)
+	{
+		scum::Manager manager;
+		auto ids = shuffled(populate(manager, n));
+		uint64_t found = 0;
+		timer.start();
+		for(auto id : ids)
+		{
+			found += manager.tryGet<Velocity>(id) != nullptr;
+		}
+		timer.stop();
+		sink = found;
+	});
+
+	bench.run("remove", n, n, [&](Timer& timer)
+	{
+		scum::Manager manager;
+		auto ids = shuffled(populate(manager, n));
+		timer.start();
+		for(auto id : ids)
+		{
+			manager.remove<Position>(id);
+		}
+		timer.stop();
+	});
+
+	bench.run("destroy", n, n, [&](Timer& timer)
+	{
+		scum::Manager manager;
+		auto ids = shuffled(populate(manager, n));
+		timer.start();
+		for(auto id : ids)
+		{
+			manager.destroy(id);
+		}
+		timer.stop();
+	});
+
+	bench.run("iterate", n, n, [&](Timer& timer)
+	{
+		scum::Manager manager;
+		populate(manager, n);
+		float total = 0.0f;
+		timer.start();
+		for(auto pair : manager.getPool<Position>())
+		{
+			total += pair.data.x;
+		}
+		timer.stop();
+		sink = uint64_t(total);
+	});
+
+	runSearch<Position>(bench, "search1", n);
+	runSearch<Position, Velocity>(bench, "search2", n);
+	runSearch<Position, Velocity, Health>(bench, "search3", n);
+	runSearch<Position, Velocity, Health, Tag>(bench, "search4", n);
+
+	// n queued additions and n / 10 queued destructions
+	bench.run("processQueues", n, n + n / 10, [&](Timer& timer)
+	{
+		scum::Manager manager;
+		auto ids = populate(manager, n / 10);
+		for(size_t i = 0; i < n; i++)
+		{
+			manager.queueAdd<Position>(manager.newID(), 1.0f, 2.0f, 3.0f);
+		}
+		for(auto id : ids)
+		{
+			manager.queueDestroy(id);
+		}
+		timer.start();
+		manager.processQueues();
+		timer.stop();
+	});
+
+	// destroying and recreating half of the entities in a random order
+	// leaves the pools out of ID order, so lookups and multi-pool searches
+	// jump around in memory
+	auto fragment = [n](scum::Manager& manager)
+	{
+		auto ids = shuffled(populate(manager, n));
+		for(size_t i = 0; i < n / 2; i++)
+		{
+			manager.destroy(ids[i]);
+		}
+		ids.erase(ids.begin(), ids.begin() + n / 2);
+		auto added = populate(manager, n / 2);
+		ids.insert(ids.end(), added.begin(), added.end());
+		return shuffled(ids, 2);
+	};
+
+	bench.run("fragmented.get", n, n, [&](Timer& timer)
+	{
+		scum::Manager manager;
+		auto ids = fragment(manager);
+		float total = 0.0f;
+		timer.start();
+		for(auto id : ids)
+		{
+			total += manager.get<Position>(id)->x;
+		}
+		timer.stop();
+		sink = uint64_t(total);
+	});
+
+	bench.run("fragmented.search2", n, n, [&](Timer& timer)
+	{
+		scum::Manager manager;
+		fragment(manager);
+		uint64_t found = 0;
+		timer.start();
+		for(auto id : manager.search<Position, Velocity>())
+		{
+			found += manager.get<Position>(id)->x > 0.0f;
+		}
+		timer.stop();
+		sink = found;
+	});
+
+	bench.run("fragmented.search2.prefetch", n, n, [&](Timer& timer)
+	{
+		scum::Manager manager;
+		fragment(manager);
+		uint64_t found = 0;
+		timer.start();
+		for(auto id : manager.search<Position, Velocity>().withPrefetch())
+		{
+			found += manager.get<Position>(id)->x > 0.0f;
+		}
+		timer.stop();
+		sink = found;
+	});
+
+	bench.run("fragmented.defragment", n, n, [&](Timer& timer)
+	{
+		scum::Manager manager;
+		fragment(manager);
+		timer.start();
+		manager.defragment();
+		timer.stop();
+	});
+
+	// restores the frame before one which moved everything and replaced a
+	// hundredth of the entities. most entities are still where they were,
+	// so their lookup table entries are kept
+	bench.run("rollback.restore", n, n, [&](Timer& timer)
+	{
+		scum::Manager manager;
+		auto ids = populate(manager, n);
+		scum::Rollback rollback(2);
+		rollback.capture(manager, 0);
+		for(auto pair : manager.getPool<Position>())
+		{
+			pair.data.x += 1.0f;
+		}
+		for(size_t i = 0; i < n / 100; i++)
+		{
+			manager.destroy(ids[i * 100]);
+			manager.add<Position>(manager.newID(), 1.0f, 2.0f, 3.0f);
+		}
+		timer.start();
+		rollback.restore(manager, 0);
+		timer.stop();
+	});
+
+	// each round destroys a tenth of the entities and creates as many new
+	// ones, through the queues
+	const size_t rounds = 10;
+	bench.run("churn", n, rounds * (n / 10) * 2, [&](Timer& timer)
+	{
+		scum::Manager manager;
+		auto ids = populate(manager, n);
+		std::mt19937 random(3);
+		timer.start();
+		for(size_t round = 0; round < rounds; round++)
+		{
+			for(size_t i = 0; i < n / 10; i++)
+			{
+				size_t index = random() % ids.size();
+				manager.queueDestroy(ids[index]);
+				auto id = manager.newID();
+				manager.queueAdd<Position>(id, 1.0f, 2.0f, 3.0f);
+				manager.queueAdd<Velocity>(id, 1.0f, 0.0f, 0.0f);
+				ids[index] = id;
+			}
+			manager.processQueues();
+		}
+		timer.stop();
+	});
+}
+
+void poolScenarios(Harness& bench, size_t n)
+{
+	bool spaced = n <= managerLimit;
+#if SCUM_LOOKUP_BACKEND == SCUM_LOOKUP_SPARSE
+	if(!spaced)
+	{
+		return;
+	}
+#endif
+	std::vector<scum::ID> ids(n);
+	for(size_t i = 0; i < n; i++)
+	{
+		ids[i] = spaced ? scum::ID((i + 1) * scum::IDStride) : scum::ID(i + 1);
+	}
+	auto random = shuffled(ids);
+	auto fill = [&](scum::Pool<Position>& pool)
+	{
+		for(auto id : ids)
+		{
+			pool.add(id, 1.0f, 2.0f, 3.0f);
+		}
+	};
+
+	bench.run("pool.add", n, n, [&](Timer& timer)
+	{
+		scum::Pool<Position> pool;
+		timer.start();
+		fill(pool);
+		timer.stop();
+	});
+
+	bench.run("pool.get", n, n, [&](Timer& timer)
+	{
+		scum::Pool<Position> pool;
+		fill(pool);
+		float total = 0.0f;
+		timer.start();
+		for(auto id : random)
+		{
+			total += pool.get(id)->x;
+		}
+		timer.stop();
+		sink = uint64_t(total);
+	});
+
+	bench.run("pool.getMany", n, n, [&](Timer& timer)
+	{
+		scum::Pool<Position> pool;
+		fill(pool);
+		std::vector<Position*> found(batchSize);
+		float total = 0.0f;
+		timer.start();
+		for(size_t i = 0; i < n; i += batchSize)
+		{
+			size_t count = std::min(batchSize, n - i);
+			pool.getMany(random.data() + i, count, found.data());
+			for(size_t j = 0; j < count; j++)
+			{
+				total += found[j]->x;
+			}
+		}
+		timer.stop();
+		sink = uint64_t(total);
+	});
+
+	bench.run("pool.iterate", n, n, [&](Timer& timer)
+	{
+		scum::Pool<Position> pool;
+		fill(pool);
+		float total = 0.0f;
+		timer.start();
+		for(auto pair : pool)
+		{
+			total += pair.data.x;
+		}
+		timer.stop();
+		sink = uint64_t(total);
+	});
+
+	bench.run("pool.remove", n, n, [&](Timer& timer)
+	{
+		scum::Pool<Position> pool;
+		fill(pool);
+		timer.start();
+		for(auto id : random)
+		{
+			pool.remove(id);
+		}
+		timer.stop();
+	});
+}
+
+
+// simulates a game loop in a world of entities with a Position and a
+// Velocity. each frame moves every entity, destroys and spawns a hundredth
+// of the world through the queues, adds the change extra(frame) returns to
+// the population, and processes the queues. with a budget, the manager and
+// its pools reserve everything they'll need before the first frame
+template<typename Fn>
+void gameLoop(Harness& bench, const std::string& name, size_t n,
+	size_t initial, bool budget, Fn extra)
+{
+	const size_t frames = 1000;
+	bench.runFrames(name, n, [&](scum::Manager& manager, FrameTimer& timer)
+	{
+		if(budget)
+		{
+			// pools add queued components before removing destroyed ones,
+			// so they briefly hold a frame's spawns on top of the world
+			size_t count = n + n / 50;
+			size_t queued = n / 4 + n / 50;
+			manager.setBudget(count, queued);
+			manager.setBudget<Position>(count, queued);
+			manager.setBudget<Velocity>(count, queued);
+		}
+		std::vector<scum::ID> live;
+		std::mt19937 random(4);
+		auto spawn = [&]()
+		{
+			auto id = manager.newID();
+			manager.queueAdd<Position>(id, 0.0f, 0.0f, 0.0f);
+			manager.queueAdd<Velocity>(id, 1.0f, 0.0f, 0.0f);
+			live.push_back(id);
+		};
+		auto despawn = [&]()
+		{
+			size_t index = random() % live.size();
+			manager.queueDestroy(live[index]);
+			live[index] = live.back();
+			live.pop_back();
+		};
+
+		for(size_t i = 0; i < initial; i++)
+		{
+			auto id = manager.newID();
+			manager.add<Position>(id, 0.0f, 0.0f, 0.0f);
+			manager.add<Velocity>(id, 1.0f, 0.0f, 0.0f);
+			live.push_back(id);
+		}
+
+		float total = 0.0f;
+		for(size_t frame = 0; frame < frames; frame++)
+		{
+			ptrdiff_t change = extra(frame);
+			size_t spawns = n / 100 + (change > 0 ? change : 0);
+			size_t despawns = n / 100 + (change < 0 ? -change : 0);
+			timer.start();
+			for(auto pair : manager.getPool<Position>())
+			{
+				pair.data.x += 1.0f;
+				total += pair.data.x;
+			}
+			for(size_t i = 0; i < despawns && !live.empty(); i++)
+			{
+				despawn();
+			}
+			for(size_t i = 0; i < spawns; i++)
+			{
+				spawn();
+			}
+			manager.processQueues();
+			timer.stop();
+		}
+		sink = uint64_t(total);
+	});
+}
+
+// game loops of 1000 frames which peak at about n entities
+void frameScenarios(Harness& bench, size_t n)
+{
+	// the population stays at n
+	auto steady = [](size_t)
+	{
+		return ptrdiff_t(0);
+	};
+	// a quarter of the world spawns at once every 60 frames and is
+	// destroyed 30 frames later
+	auto burst = [&](size_t frame)
+	{
+		return frame % 60 == 0 ? ptrdiff_t(n / 4) :
+			frame % 60 == 30 ? -ptrdiff_t(n / 4) : ptrdiff_t(0);
+	};
+	// the population grows steadily from n / 2 to n, so pools keep growing
+	auto growth = [&](size_t)
+	{
+		return ptrdiff_t(n / 2 / 1000);
+	};
+	gameLoop(bench, "frames.steady", n, n, false, steady);
+	gameLoop(bench, "frames.burst", n, n - n / 4, false, burst);
+	gameLoop(bench, "frames.growth", n, n / 2, false, growth);
+	// the same with budgets set up front (see Manager::setBudget)
+	gameLoop(bench, "frames.burst.budget", n, n - n / 4, true, burst);
+	gameLoop(bench, "frames.growth.budget", n, n / 2, true, growth);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	size_t maxEntities = managerLimit;
+	std::string filter;
+	const char* outPath = nullptr;
+	bool useCounters = false;
+	for(int i = 1; i < argc; i++)
+	{
+		bool hasValue = i + 1 < argc;
+		if(std::strcmp(argv[i], "--max") == 0 && hasValue)
+		{
+			maxEntities = std::strtoull(argv[++i], nullptr, 10);
+		}
+		else if(std::strcmp(argv[i], "--filter") == 0 && hasValue)
+		{
+			filter = argv[++i];
+		}
+		else if(std::strcmp(argv[i], "--out") == 0 && hasValue)
+		{
+			outPath = argv[++i];
+		}
+		else if(std::strcmp(argv[i], "--counters") == 0)
+		{
+			useCounters = true;
+		}
+		else
+		{
+			std::fprintf(stderr, "usage: %s [--max N] [--filter TEXT] "
+				"[--out PATH] [--counters]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	Counters counters;
+	if(useCounters && !counters.any())
+	{
+		std::fprintf(stderr, "hardware counters aren't available, so only "
+			"times will be reported\n");
+		useCounters = false;
+	}
+	Harness bench(maxEntities, filter, useCounters ? &counters : nullptr);
+	for(size_t n = 1000; n <= maxEntities; n *= 10)
+	{
+		if(n <= managerLimit)
+		{
+			managerScenarios(bench, n);
+			frameScenarios(bench, n);
+		}
+		poolScenarios(bench, n);
+	}
+
+	std::FILE* out = outPath != nullptr ? std::fopen(outPath, "w") : stdout;
+	if(out == nullptr)
+	{
+		std::fprintf(stderr, "can't open %s\n", outPath);
+		return 1;
+	}
+	bool ok = bench.writeJSON(out);
+	if(out != stdout)
+	{
+		ok = std::fclose(out) == 0 && ok;
+	}
+	return ok ? 0 : 1;
+}
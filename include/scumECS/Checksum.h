@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace scum
+{
+
+// hashes a block of memory, for checking that two worlds are identical
+// (see Manager::checksum). the main loop reads 32 bytes at a time into four
+// independent lanes, so it isn't limited by the latency of one long chain
+// of multiplies and can be vectorized. this is not a cryptographic hash.
+inline uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 0)
+{
+	const uint64_t prime1 = 0x9e3779b185ebca87;
+	const uint64_t prime2 = 0xc2b2ae3d27d4eb4f;
+	const uint64_t prime3 = 0x165667b19e3779f9;
+	auto rotate = [](uint64_t value, int bits)
+	{
+		return (value << bits) | (value >> (64 - bits));
+	};
+	auto round = [&](uint64_t lane, uint64_t word)
+	{
+		return rotate(lane + word * prime2, 31) * prime1;
+	};
+
+	const char* bytes = static_cast<const char*>(data);
+	uint64_t lanes[4] = {seed + prime1 + prime2, seed + prime2, seed,
+		seed - prime1};
+	size_t i = 0;
+	for(; i + 32 <= size; i += 32)
+	{
+		for(int lane = 0; lane < 4; lane++)
+		{
+			uint64_t word;
+			std::memcpy(&word, bytes + i + lane * 8, sizeof(word));
+			lanes[lane] = round(lanes[lane], word);
+		}
+	}
+
+	uint64_t hash = rotate(lanes[0], 1) + rotate(lanes[1], 7) +
+		rotate(lanes[2], 12) + rotate(lanes[3], 18) + size;
+	for(; i + 8 <= size; i += 8)
+	{
+		uint64_t word;
+		std::memcpy(&word, bytes + i, sizeof(word));
+		hash = rotate(hash ^ round(0, word), 27) * prime1 + prime3;
+	}
+	for(; i < size; i++)
+	{
+		hash = rotate(hash ^ (static_cast<uint8_t>(bytes[i]) * prime3), 11)
+			* prime1;
+	}
+
+	hash ^= hash >> 33;
+	hash *= prime2;
+	hash ^= hash >> 29;
+	hash *= prime3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+}
@@ -0,0 +1,174 @@
+#pragma once
+
+#include "Types.h"
+#include "Snapshot.h"
+#include "TypeRegistry.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace scum
+{
+
+// an append-only record of the operations applied to a manager, which can
+// be replayed into another manager to rebuild the same world (see
+// Manager::record and Manager::replay). each entry is an Op byte and an
+// entity ID. additions also store the component's type key (see TypeName),
+// its size in bytes, and its bytes, which are raw for trivially copyable
+// components and whatever the type's Serializer writes otherwise.
+class CommandLog
+{
+public:
+	enum Op : uint8_t
+	{
+		NewID,
+		Add,
+		Remove,
+		Destroy,
+		QueueAdd,
+		QueueDestroy,
+		ProcessQueues,
+		Disable,
+		Enable
+	};
+
+	void record(Op op, ID id);
+	template<typename C>
+	void record(Op op, ID id, const C& component);
+	template<typename C>
+	void recordType(Op op, ID id);
+
+	const std::vector<char>& data() const;
+	size_t size() const;
+	bool good() const;
+	void clear();
+
+	bool save(const std::string& path) const;
+	bool load(const std::string& path);
+
+private:
+	static constexpr uint32_t Magic = 0x4c4d4353; // "SCML"
+	static constexpr uint32_t Version = 2;
+
+	template<typename T>
+	void append(const T& value);
+
+	std::vector<char> bytes;
+	bool ok = true;
+};
+
+// appends an operation which only involves an entity ID
+inline void CommandLog::record(Op op, ID id)
+{
+	append(static_cast<uint8_t>(op));
+	append(id);
+}
+
+// appends an addition along with the component's bytes. components which
+// can't be stored in snapshots can't be recorded either, and mark the log
+// as incomplete (see good)
+template<typename C>
+void CommandLog::record(Op op, ID id, const C& component)
+{
+	if constexpr (!canSnapshot<C>)
+	{
+		ok = false;
+	}
+	else
+	{
+		recordType<C>(op, id);
+		size_t start = bytes.size();
+		append(uint32_t(0));
+		if constexpr (rawSnapshot<C>)
+		{
+			append(component);
+		}
+		else
+		{
+			SnapshotWriter out(bytes);
+			Serializer<C>::write(component, out);
+		}
+		uint32_t length = bytes.size() - start - sizeof(uint32_t);
+		std::memcpy(bytes.data() + start, &length, sizeof(uint32_t));
+	}
+}
+
+// appends an operation on one of an entity's components
+template<typename C>
+void CommandLog::recordType(Op op, ID id)
+{
+	record(op, id);
+	append(TypeRegistry::get<C>()->key);
+}
+
+inline const std::vector<char>& CommandLog::data() const
+{
+	return bytes;
+}
+
+// returns the size of the log in bytes
+inline size_t CommandLog::size() const
+{
+	return bytes.size();
+}
+
+// returns false if an operation couldn't be recorded, in which case
+// replaying the log won't rebuild the same world
+inline bool CommandLog::good() const
+{
+	return ok;
+}
+
+inline void CommandLog::clear()
+{
+	bytes.clear();
+	ok = true;
+}
+
+// writes the log to a file
+inline bool CommandLog::save(const std::string& path) const
+{
+	std::FILE* file = std::fopen(path.c_str(), "wb");
+	if(file == nullptr)
+	{
+		return false;
+	}
+	SnapshotWriter out(file);
+	out.writeValue(Magic);
+	out.writeValue(Version);
+	out.write(bytes.data(), bytes.size());
+	bool written = out.good();
+	return (std::fclose(file) == 0) && written;
+}
+
+// replaces the log with one read from a file
+inline bool CommandLog::load(const std::string& path)
+{
+	MappedFile file;
+	if(!file.open(path))
+	{
+		return false;
+	}
+	SnapshotReader in(file.data(), file.size());
+	if(in.readValue<uint32_t>() != Magic || in.readValue<uint32_t>() != Version)
+	{
+		return false;
+	}
+	size_t length = in.remaining();
+	const char* data = in.take(length);
+	bytes.assign(data, data + length);
+	ok = true;
+	return true;
+}
+
+template<typename T>
+void CommandLog::append(const T& value)
+{
+	const char* data = reinterpret_cast<const char*>(&value);
+	bytes.insert(bytes.end(), data, data + sizeof(T));
+}
+
+}
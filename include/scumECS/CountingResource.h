@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <memory_resource>
+
+namespace scum
+{
+
+// a memory resource which passes allocations on to another one and counts
+// them, for proving that a world stops allocating once it has warmed up.
+// give it to a Manager, which allocates all of its pools, lookup tables,
+// and queues from it, then call mark() before the frames which shouldn't
+// allocate and check allocationsSinceMark() after them. the counts are
+// atomic, so managers on different threads can share one resource.
+class CountingResource : public std::pmr::memory_resource
+{
+public:
+	explicit CountingResource(std::pmr::memory_resource* upstream
+		= std::pmr::get_default_resource());
+
+	void mark();
+	size_t allocationsSinceMark() const;
+	void assertNoAllocationsSinceMark() const;
+
+	size_t allocations() const;
+	size_t deallocations() const;
+	size_t bytesInUse() const;
+	size_t peakBytes() const;
+	std::pmr::memory_resource* upstream() const;
+
+private:
+	void* do_allocate(size_t bytes, size_t alignment) override;
+	void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+	bool do_is_equal(const std::pmr::memory_resource& other) const
+		noexcept override;
+
+	std::pmr::memory_resource* next;
+	std::atomic<size_t> allocationCount{0};
+	std::atomic<size_t> deallocationCount{0};
+	std::atomic<size_t> inUse{0};
+	std::atomic<size_t> peak{0};
+	std::atomic<size_t> marked{0}; // allocationCount when mark() was called
+};
+
+inline CountingResource::CountingResource(std::pmr::memory_resource* upstream)
+	: next(upstream)
+{}
+
+// starts a new window for allocationsSinceMark()
+inline void CountingResource::mark()
+{
+	marked = allocationCount.load();
+}
+
+inline size_t CountingResource::allocationsSinceMark() const
+{
+	return allocationCount - marked;
+}
+
+// fails an assertion if anything has been allocated since mark(). does
+// nothing in builds without assertions
+inline void CountingResource::assertNoAllocationsSinceMark() const
+{
+	assert(allocationsSinceMark() == 0);
+}
+
+inline size_t CountingResource::allocations() const
+{
+	return allocationCount;
+}
+
+inline size_t CountingResource::deallocations() const
+{
+	return deallocationCount;
+}
+
+inline size_t CountingResource::bytesInUse() const
+{
+	return inUse;
+}
+
+// returns the most bytes which have been allocated at once
+inline size_t CountingResource::peakBytes() const
+{
+	return peak;
+}
+
+inline std::pmr::memory_resource* CountingResource::upstream() const
+{
+	return next;
+}
+
+inline void* CountingResource::do_allocate(size_t bytes, size_t alignment)
+{
+	void* p = next->allocate(bytes, alignment);
+	allocationCount++;
+	size_t now = inUse += bytes;
+	size_t highest = peak;
+	while(now > highest && !peak.compare_exchange_weak(highest, now))
+	{}
+	return p;
+}
+
+inline void CountingResource::do_deallocate(void* p, size_t bytes,
+	size_t alignment)
+{
+	next->deallocate(p, bytes, alignment);
+	deallocationCount++;
+	inUse -= bytes;
+}
+
+inline bool CountingResource::do_is_equal
+	(const std::pmr::memory_resource& other) const noexcept
+{
+	return this == &other;
+}
+
+}
@@ -0,0 +1,627 @@
+#pragma once
+
+#include "Types.h"
+#include "Snapshot.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace scum
+{
+
+// encodes the difference between two snapshots (see Manager::save) so that
+// the second can be rebuilt from the first. each pool is described entity
+// by entity: runs of entities which are unchanged since the base snapshot
+// are copied, changed components are stored as the XOR of their old and new
+// bytes with runs of zeroes left out, new entities are stored in full, and
+// the IDs of removed entities are listed.
+class Delta
+{
+public:
+	static bool make(const std::vector<char>& base,
+		const std::vector<char>& current, std::vector<char>& delta);
+	static bool apply(const std::vector<char>& base,
+		const std::vector<char>& delta, std::vector<char>& current);
+	static bool removedIDs(const std::vector<char>& delta,
+		std::vector<ID>& removed);
+
+private:
+	static constexpr uint32_t Magic = 0x444d4353; // "SCMD"
+	static constexpr uint32_t Version = 1;
+
+	enum Op : uint8_t
+	{
+		Copy, // a run of entities which haven't changed
+		Change, // an entity whose component has changed
+		Add // an entity which isn't in the base pool
+	};
+
+	struct DeltaHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t baseSize;
+		uint64_t preludeSize;
+		uint64_t poolCount;
+	};
+
+	struct Section
+	{
+		PoolHeader header;
+		const char* ids;
+		const char* components;
+		// start of each serialized component, plus the end of the last one
+		std::vector<size_t> offsets;
+
+		ID id(size_t index) const;
+		const char* component(size_t index) const;
+		size_t componentSize(size_t index) const;
+	};
+
+	struct Parsed
+	{
+		size_t preludeSize; // the bytes before the first pool section
+		std::vector<Section> pools;
+	};
+
+	static bool parse(const std::vector<char>& snapshot, Parsed& parsed);
+	static void pad(std::vector<char>& out);
+	static void writeBytes(std::vector<char>& out, const void* data,
+		size_t size);
+	static void writeVarint(std::vector<char>& out, uint64_t value);
+	static uint64_t readVarint(SnapshotReader& in);
+	static void encodeXor(std::vector<char>& out, const char* base,
+		size_t baseSize, const char* current, size_t currentSize);
+	static bool decodeXor(SnapshotReader& in, const char* base,
+		size_t baseSize, char* current, size_t currentSize);
+};
+
+inline ID Delta::Section::id(size_t index) const
+{
+	ID id;
+	std::memcpy(&id, ids + index * sizeof(ID), sizeof(ID));
+	return id;
+}
+
+inline const char* Delta::Section::component(size_t index) const
+{
+	if(header.raw)
+	{
+		return components + index * header.componentSize;
+	}
+	return components + offsets[index];
+}
+
+inline size_t Delta::Section::componentSize(size_t index) const
+{
+	if(header.raw)
+	{
+		return header.componentSize;
+	}
+	return offsets[index + 1] - offsets[index];
+}
+
+// splits a snapshot into its pool sections. counts come from the snapshot,
+// so they're checked against what's left of it before being multiplied,
+// as Manager::load does
+inline bool Delta::parse(const std::vector<char>& snapshot, Parsed& parsed)
+{
+	SnapshotReader in(snapshot.data(), snapshot.size());
+	auto header = in.readValue<SnapshotHeader>();
+	auto fits = [&in](uint64_t count)
+	{
+		return count <= in.remaining() / sizeof(ID);
+	};
+	if(header.magic != SnapshotMagic || header.version != SnapshotVersion)
+	{
+		return false;
+	}
+	in.pad();
+	if(!fits(header.freeIDCount))
+	{
+		return false;
+	}
+	in.skip(header.freeIDCount * sizeof(ID));
+	in.pad();
+	if(!fits(header.disabledIDCount))
+	{
+		return false;
+	}
+	in.skip(header.disabledIDCount * sizeof(ID));
+	in.pad();
+	parsed.preludeSize = in.offset();
+	parsed.pools.clear();
+
+	for(uint64_t i = 0; i < header.poolCount && in.good(); i++)
+	{
+		Section section;
+		section.header = in.readValue<PoolHeader>();
+		in.pad();
+		const PoolHeader& pool = section.header;
+		if(pool.active > pool.count || !fits(pool.count))
+		{
+			return false;
+		}
+		section.ids = in.take(pool.count * sizeof(ID));
+		in.pad();
+		// divided rather than multiplied, which could overflow
+		if(pool.raw && (pool.count == 0 ? pool.componentBytes != 0 :
+			pool.componentBytes % pool.count != 0 ||
+			pool.componentBytes / pool.count != pool.componentSize))
+		{
+			return false;
+		}
+		section.components = in.take(pool.componentBytes);
+		in.pad();
+		if(!in.good())
+		{
+			return false;
+		}
+		if(!section.header.raw)
+		{
+			SnapshotReader elements(section.components,
+				section.header.componentBytes);
+			for(uint64_t j = 0; j < section.header.count && elements.good();
+				j++)
+			{
+				section.offsets.push_back(elements.offset());
+				elements.skip(elements.readValue<uint32_t>());
+			}
+			section.offsets.push_back(elements.offset());
+			if(!elements.good())
+			{
+				return false;
+			}
+		}
+		parsed.pools.push_back(std::move(section));
+	}
+	return in.good();
+}
+
+// writes the delta which turns the base snapshot into the current one
+inline bool Delta::make(const std::vector<char>& base,
+	const std::vector<char>& current, std::vector<char>& delta)
+{
+	Parsed from;
+	Parsed to;
+	if(!parse(base, from) || !parse(current, to))
+	{
+		return false;
+	}
+
+	delta.clear();
+	DeltaHeader header{Magic, Version, base.size(), to.preludeSize,
+		to.pools.size()};
+	writeBytes(delta, &header, sizeof(header));
+	encodeXor(delta, base.data(), from.preludeSize,
+		current.data(), to.preludeSize);
+
+	std::vector<size_t> slots; // base index + 1 of each ID slot, or 0
+	std::vector<bool> kept;
+	std::vector<char> ops;
+	std::vector<char> encoded;
+	for(auto& pool : to.pools)
+	{
+		writeBytes(delta, &pool.header, sizeof(PoolHeader));
+
+		const Section* old = nullptr;
+		for(auto& candidate : from.pools)
+		{
+			if(candidate.header.type == pool.header.type)
+			{
+				old = &candidate;
+			}
+		}
+		uint64_t oldCount = old != nullptr ? old->header.count : 0;
+		slots.clear();
+		kept.assign(oldCount, false);
+		for(uint64_t i = 0; i < oldCount; i++)
+		{
+			ID slot = slotOf(old->id(i));
+			if(slot >= slots.size())
+			{
+				slots.resize(slot + 1, 0);
+			}
+			slots[slot] = i + 1;
+		}
+
+		ops.clear();
+		uint64_t opCount = 0;
+		uint64_t runStart = 0; // base index of the current copy run
+		uint64_t runLength = 0;
+		auto endRun = [&]()
+		{
+			if(runLength != 0)
+			{
+				ops.push_back(Copy);
+				writeVarint(ops, runStart);
+				writeVarint(ops, runLength);
+				opCount++;
+				runLength = 0;
+			}
+		};
+
+		for(uint64_t i = 0; i < pool.header.count; i++)
+		{
+			ID id = pool.id(i);
+			ID slot = slotOf(id);
+			size_t match = slot < slots.size() ? slots[slot] : 0;
+			if(match != 0 && old->id(match - 1) != id)
+			{
+				match = 0;
+			}
+
+			const char* data = pool.component(i);
+			size_t size = pool.componentSize(i);
+			if(match == 0 || old->componentSize(match - 1) != size)
+			{
+				endRun();
+				ops.push_back(Add);
+				writeVarint(ops, id);
+				writeVarint(ops, size);
+				writeBytes(ops, data, size);
+				opCount++;
+				continue;
+			}
+
+			uint64_t oldIndex = match - 1;
+			kept[oldIndex] = true;
+			if(std::memcmp(data, old->component(oldIndex), size) == 0)
+			{
+				if(runLength != 0 && runStart + runLength == oldIndex)
+				{
+					runLength++;
+				}
+				else
+				{
+					endRun();
+					runStart = oldIndex;
+					runLength = 1;
+				}
+				continue;
+			}
+
+			endRun();
+			ops.push_back(Change);
+			writeVarint(ops, oldIndex);
+			encoded.clear();
+			encodeXor(encoded, old->component(oldIndex), size, data, size);
+			writeVarint(ops, encoded.size());
+			writeBytes(ops, encoded.data(), encoded.size());
+			opCount++;
+		}
+		endRun();
+
+		writeVarint(delta, old != nullptr ? (old - from.pools.data()) + 1 : 0);
+		uint64_t removedCount = 0;
+		for(uint64_t i = 0; i < oldCount; i++)
+		{
+			removedCount += !kept[i];
+		}
+		writeVarint(delta, removedCount);
+		for(uint64_t i = 0; i < oldCount; i++)
+		{
+			if(!kept[i])
+			{
+				writeVarint(delta, old->id(i));
+			}
+		}
+		writeVarint(delta, opCount);
+		writeBytes(delta, ops.data(), ops.size());
+	}
+	return true;
+}
+
+// rebuilds the current snapshot from the base snapshot it was made against
+inline bool Delta::apply(const std::vector<char>& base,
+	const std::vector<char>& delta, std::vector<char>& current)
+{
+	Parsed from;
+	if(!parse(base, from))
+	{
+		return false;
+	}
+	SnapshotReader in(delta.data(), delta.size());
+	auto header = in.readValue<DeltaHeader>();
+	// a prelude holds a header and lists of free and disabled IDs, so its
+	// size is bounded before anything is allocated for it
+	const size_t maxPrelude = 3 * SnapshotAlignment + 2 * MaxIDs * sizeof(ID);
+	if(header.magic != Magic || header.version != Version ||
+		header.baseSize != base.size() || header.preludeSize > maxPrelude)
+	{
+		return false;
+	}
+
+	current.clear();
+	current.resize(header.preludeSize);
+	if(!decodeXor(in, base.data(), from.preludeSize,
+		current.data(), header.preludeSize))
+	{
+		return false;
+	}
+
+	for(uint64_t p = 0; p < header.poolCount && in.good(); p++)
+	{
+		auto poolHeader = in.readValue<PoolHeader>();
+		uint64_t oldPool = readVarint(in);
+		if(oldPool > from.pools.size())
+		{
+			return false;
+		}
+		const Section* old = oldPool != 0 ? &from.pools[oldPool - 1] : nullptr;
+		uint64_t removedCount = readVarint(in);
+		for(uint64_t i = 0; i < removedCount && in.good(); i++)
+		{
+			readVarint(in);
+		}
+
+		// the header comes from the delta too. a pool has at most one
+		// entity per ID slot, which bounds its IDs, and its components are
+		// only allocated as the ops produce them
+		if(poolHeader.count > MaxIDs || poolHeader.active > poolHeader.count ||
+			(poolHeader.raw && poolHeader.componentBytes !=
+			poolHeader.count * poolHeader.componentSize))
+		{
+			return false;
+		}
+		writeBytes(current, &poolHeader, sizeof(PoolHeader));
+		pad(current);
+		size_t idsAt = current.size();
+		current.resize(idsAt + poolHeader.count * sizeof(ID));
+		pad(current);
+		size_t componentsAt = current.size();
+
+		uint64_t written = 0;
+		size_t cursor = componentsAt;
+		// makes room for components of the given total size for count more
+		// entities, if the header has room for them
+		auto fits = [&](uint64_t count, uint64_t size)
+		{
+			if(count > poolHeader.count - written ||
+				size > poolHeader.componentBytes - (cursor - componentsAt))
+			{
+				return false;
+			}
+			current.resize(cursor + size);
+			return true;
+		};
+
+		uint64_t opCount = readVarint(in);
+		for(uint64_t i = 0; i < opCount && in.good(); i++)
+		{
+			uint8_t op = in.readValue<uint8_t>();
+			if(op == Add)
+			{
+				ID id = static_cast<ID>(readVarint(in));
+				size_t size = readVarint(in);
+				const char* data = in.take(size);
+				if(data == nullptr || !fits(1, size))
+				{
+					return false;
+				}
+				std::memcpy(current.data() + idsAt + written * sizeof(ID),
+					&id, sizeof(ID));
+				std::memcpy(current.data() + cursor, data, size);
+				cursor += size;
+				written++;
+				continue;
+			}
+
+			uint64_t oldIndex = readVarint(in);
+			uint64_t count = op == Copy ? readVarint(in) : 1;
+			if(old == nullptr || count > old->header.count ||
+				oldIndex > old->header.count - count || op > Add)
+			{
+				return false;
+			}
+			size_t size = old->header.raw ? count * old->header.componentSize
+				: old->offsets[oldIndex + count] - old->offsets[oldIndex];
+			if(!fits(count, size))
+			{
+				return false;
+			}
+			std::memcpy(current.data() + idsAt + written * sizeof(ID),
+				old->ids + oldIndex * sizeof(ID), count * sizeof(ID));
+			if(op == Copy)
+			{
+				std::memcpy(current.data() + cursor, old->component(oldIndex),
+					size);
+			}
+			else
+			{
+				size_t encodedSize = readVarint(in);
+				const char* encodedData = in.take(encodedSize);
+				SnapshotReader changes(encodedData, encodedSize);
+				if(encodedData == nullptr || !decodeXor(changes,
+					old->component(oldIndex), size, current.data() + cursor, size))
+				{
+					return false;
+				}
+			}
+			cursor += size;
+			written += count;
+		}
+		if(written != poolHeader.count ||
+			cursor - componentsAt != poolHeader.componentBytes)
+		{
+			return false;
+		}
+		pad(current);
+	}
+	return in.good();
+}
+
+// lists the IDs of the entities which lost components in a delta, once per
+// pool they were removed from
+inline bool Delta::removedIDs(const std::vector<char>& delta,
+	std::vector<ID>& removed)
+{
+	SnapshotReader in(delta.data(), delta.size());
+	auto header = in.readValue<DeltaHeader>();
+	if(header.magic != Magic || header.version != Version)
+	{
+		return false;
+	}
+	for(uint64_t zeroes = 0; zeroes < header.preludeSize && in.good();)
+	{
+		zeroes += readVarint(in);
+		uint64_t literal = readVarint(in);
+		in.skip(literal);
+		zeroes += literal;
+	}
+
+	for(uint64_t p = 0; p < header.poolCount && in.good(); p++)
+	{
+		in.skip(sizeof(PoolHeader));
+		readVarint(in);
+		uint64_t removedCount = readVarint(in);
+		for(uint64_t i = 0; i < removedCount && in.good(); i++)
+		{
+			removed.push_back(static_cast<ID>(readVarint(in)));
+		}
+		uint64_t opCount = readVarint(in);
+		for(uint64_t i = 0; i < opCount && in.good(); i++)
+		{
+			uint8_t op = in.readValue<uint8_t>();
+			if(op == Add)
+			{
+				readVarint(in);
+				in.skip(readVarint(in));
+			}
+			else
+			{
+				readVarint(in);
+				readVarint(in);
+				if(op == Change)
+				{
+					in.skip(readVarint(in));
+				}
+			}
+		}
+	}
+	return in.good();
+}
+
+// appends zeroes up to the next SnapshotAlignment boundary
+inline void Delta::pad(std::vector<char>& out)
+{
+	size_t misalignment = out.size() % SnapshotAlignment;
+	if(misalignment != 0)
+	{
+		out.resize(out.size() + SnapshotAlignment - misalignment, 0);
+	}
+}
+
+inline void Delta::writeBytes(std::vector<char>& out, const void* data,
+	size_t size)
+{
+	const char* bytes = static_cast<const char*>(data);
+	out.insert(out.end(), bytes, bytes + size);
+}
+
+// writes an unsigned integer using 7 bits per byte
+inline void Delta::writeVarint(std::vector<char>& out, uint64_t value)
+{
+	while(value >= 0x80)
+	{
+		out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<char>(value));
+}
+
+inline uint64_t Delta::readVarint(SnapshotReader& in)
+{
+	uint64_t value = 0;
+	for(int shift = 0; shift < 64 && in.good(); shift += 7)
+	{
+		uint8_t byte = in.readValue<uint8_t>();
+		value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+		if((byte & 0x80) == 0)
+		{
+			break;
+		}
+	}
+	return value;
+}
+
+// writes the current bytes as pairs of (count of bytes which are the same
+// as in base, count of bytes which differ) followed by the XOR of the
+// differing bytes. bytes past the end of base are compared against zero.
+inline void Delta::encodeXor(std::vector<char>& out, const char* base,
+	size_t baseSize, const char* current, size_t currentSize)
+{
+	auto baseAt = [&](size_t i)
+	{
+		return i < baseSize ? base[i] : char(0);
+	};
+	size_t common = baseSize < currentSize ? baseSize : currentSize;
+	size_t i = 0;
+	while(i < currentSize)
+	{
+		size_t start = i;
+		// compare a word at a time while possible
+		while(i + sizeof(uint64_t) <= common)
+		{
+			uint64_t a;
+			uint64_t b;
+			std::memcpy(&a, base + i, sizeof(uint64_t));
+			std::memcpy(&b, current + i, sizeof(uint64_t));
+			if(a != b)
+			{
+				break;
+			}
+			i += sizeof(uint64_t);
+		}
+		while(i < currentSize && baseAt(i) == current[i])
+		{
+			i++;
+		}
+		writeVarint(out, i - start);
+
+		start = i;
+		while(i < currentSize && baseAt(i) != current[i])
+		{
+			i++;
+		}
+		writeVarint(out, i - start);
+		for(size_t j = start; j < i; j++)
+		{
+			out.push_back(static_cast<char>(baseAt(j) ^ current[j]));
+		}
+	}
+}
+
+// reverses encodeXor, writing exactly currentSize bytes
+inline bool Delta::decodeXor(SnapshotReader& in, const char* base,
+	size_t baseSize, char* current, size_t currentSize)
+{
+	size_t i = 0;
+	while(i < currentSize && in.good())
+	{
+		uint64_t same = readVarint(in);
+		if(same > currentSize - i)
+		{
+			return false;
+		}
+		for(size_t end = i + same; i < end; i++)
+		{
+			current[i] = i < baseSize ? base[i] : char(0);
+		}
+
+		uint64_t different = readVarint(in);
+		const char* bytes = in.take(different);
+		if(bytes == nullptr || different > currentSize - i)
+		{
+			return false;
+		}
+		for(size_t j = 0; j < different; j++, i++)
+		{
+			current[i] = (i < baseSize ? base[i] : char(0)) ^ bytes[j];
+		}
+	}
+	return in.good();
+}
+
+}
@@ -4,3 +4,17 @@
 #include "Entity.h"
 #include "Search.h"
 #include "Pool.h"
+#include "Storage.h"
+#include "EntityMap.h"
+#include "SparseMap.h"
+#include "FlatMap.h"
+#include "EpochIndex.h"
+#include "Snapshot.h"
+#include "TypeRegistry.h"
+#include "Delta.h"
+#include "Rollback.h"
+#include "CommandLog.h"
+#include "Checksum.h"
+#include "Stats.h"
+#include "Profiler.h"
+#include "CountingResource.h"
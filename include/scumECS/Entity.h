@@ -24,6 +24,8 @@ public:
 	C* queueAdd(Args... args);
 	template<typename C>
 	void remove();
+	void disable();
+	void enable();
 private:
 	Manager& manager;
 };
@@ -74,4 +76,14 @@ void Entity::remove()
 	manager.remove<C>(id);
 }
 
+inline void Entity::disable()
+{
+	manager.disable(id);
+}
+
+inline void Entity::enable()
+{
+	manager.enable(id);
+}
+
 }
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "Types.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <unordered_map>
+#include <utility>
+
+// the table pools use to find an entity's component. define
+// SCUM_LOOKUP_BACKEND as one of these before including the library to pick
+// another, e.g. to compare them with scumECS_bench. every translation unit
+// in a program must pick the same one, and every pool uses it. only FlatMap
+// grows incrementally; the others, including the default, move every entry
+// at once when they grow, which Pool::setBudget and Pool::reserve avoid
+#define SCUM_LOOKUP_ROBIN 0 // tsl::robin_map, the default
+#define SCUM_LOOKUP_STD 1 // std::unordered_map
+// SparseMap, an array indexed by slot. pools can then only hold IDs from a
+// manager, or others which never share a slot
+#define SCUM_LOOKUP_SPARSE 2
+#define SCUM_LOOKUP_FLAT 3 // FlatMap, SIMD probing in groups of sixteen
+
+#ifndef SCUM_LOOKUP_BACKEND
+#define SCUM_LOOKUP_BACKEND SCUM_LOOKUP_ROBIN
+#endif
+
+#if SCUM_LOOKUP_BACKEND == SCUM_LOOKUP_SPARSE
+#include "SparseMap.h"
+#elif SCUM_LOOKUP_BACKEND == SCUM_LOOKUP_FLAT
+#include "FlatMap.h"
+#endif
+
+namespace scum
+{
+
+#if SCUM_LOOKUP_BACKEND == SCUM_LOOKUP_ROBIN
+template<typename V>
+using EntityMap = tsl::robin_map<ID, V, IDHash, std::equal_to<ID>,
+	std::pmr::polymorphic_allocator<std::pair<ID,V>>>;
+#elif SCUM_LOOKUP_BACKEND == SCUM_LOOKUP_STD
+template<typename V>
+using EntityMap = std::unordered_map<ID, V, IDHash, std::equal_to<ID>,
+	std::pmr::polymorphic_allocator<std::pair<const ID,V>>>;
+#elif SCUM_LOOKUP_BACKEND == SCUM_LOOKUP_SPARSE
+template<typename V>
+using EntityMap = SparseMap<V>;
+#elif SCUM_LOOKUP_BACKEND == SCUM_LOOKUP_FLAT
+template<typename V>
+using EntityMap = FlatMap<V>;
+#else
+#error "unknown SCUM_LOOKUP_BACKEND"
+#endif
+
+// returns the name of the lookup backend in use
+inline const char* lookupBackend()
+{
+#if SCUM_LOOKUP_BACKEND == SCUM_LOOKUP_ROBIN
+	return "robin";
+#elif SCUM_LOOKUP_BACKEND == SCUM_LOOKUP_STD
+	return "std";
+#elif SCUM_LOOKUP_BACKEND == SCUM_LOOKUP_SPARSE
+	return "sparse";
+#else
+	return "flat";
+#endif
+}
+
+// starts loading the part of a lookup table a find for an ID would read
+// first. robin_map and std::unordered_map don't expose their buckets, so
+// with them this does nothing and only the component loads are overlapped
+template<typename V>
+void prefetchLookup(const EntityMap<V>& map, ID id)
+{
+#if SCUM_LOOKUP_BACKEND == SCUM_LOOKUP_SPARSE || \
+	SCUM_LOOKUP_BACKEND == SCUM_LOOKUP_FLAT
+	map.prefetch(id);
+#else
+	(void)map;
+	(void)id;
+#endif
+}
+
+// returns roughly how much memory a lookup table has allocated
+template<typename V>
+size_t lookupBytes(const EntityMap<V>& map)
+{
+#if SCUM_LOOKUP_BACKEND == SCUM_LOOKUP_ROBIN
+	// each bucket holds an entry and its distance from its ideal bucket
+	return map.bucket_count() * (sizeof(std::pair<ID,V>) + sizeof(int16_t));
+#elif SCUM_LOOKUP_BACKEND == SCUM_LOOKUP_STD
+	// a pointer per bucket and a node per entry, which also holds a pointer
+	return map.bucket_count() * sizeof(void*) +
+		map.size() * (sizeof(std::pair<const ID,V>) + sizeof(void*));
+#else
+	return map.bytes();
+#endif
+}
+
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "Types.h"
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+namespace scum
+{
+
+// maps entity IDs to pool indices using a flat array indexed by ID slot.
+// every entry is stamped with the epoch it was written in, and entries from
+// older epochs count as empty, so the whole index is cleared in O(1)
+// by advancing the epoch. as with SparseMap, IDs which share a slot would
+// replace each other, so it only works when, as with IDs from one manager,
+// no two IDs in the index share a slot. debug builds assert this.
+class EpochIndex
+{
+public:
+	static constexpr size_t npos = ~size_t(0);
+
+	explicit EpochIndex(std::pmr::memory_resource* resource);
+
+	bool contains(ID id) const;
+	size_t find(ID id) const;
+	void prefetch(ID id) const;
+	void set(ID id, size_t index);
+	void erase(ID id);
+	void clear();
+	size_t slots() const;
+	size_t bytes() const;
+
+private:
+	struct Entry
+	{
+		ID id;
+		uint32_t epoch;
+		uint32_t index;
+	};
+
+	std::pmr::vector<Entry> entries;
+	uint32_t epoch = 1;
+};
+
+inline EpochIndex::EpochIndex(std::pmr::memory_resource* resource)
+	: entries(resource)
+{}
+
+// checks if the index has an entry for the given ID in the current epoch
+inline bool EpochIndex::contains(ID id) const
+{
+	return find(id) != npos;
+}
+
+// returns the index stored for the given ID, or npos if there is none
+inline size_t EpochIndex::find(ID id) const
+{
+	ID slot = slotOf(id);
+	if(slot >= entries.size())
+	{
+		return npos;
+	}
+	const Entry& entry = entries[slot];
+	if(entry.epoch != epoch || entry.id != id)
+	{
+		return npos;
+	}
+	return entry.index;
+}
+
+// starts loading the entry for an ID, for a find soon after
+inline void EpochIndex::prefetch(ID id) const
+{
+	ID slot = slotOf(id);
+	if(slot < entries.size())
+	{
+		scum::prefetch(&entries[slot]);
+	}
+}
+
+// stores the index for the given ID, replacing any previous entry
+inline void EpochIndex::set(ID id, size_t index)
+{
+	ID slot = slotOf(id);
+	if(slot >= entries.size())
+	{
+		entries.resize(slot + 1, Entry{Null, 0, 0});
+	}
+	assert(entries[slot].epoch != epoch || entries[slot].id == id);
+	entries[slot] = Entry{id, epoch, static_cast<uint32_t>(index)};
+}
+
+// removes the entry for the given ID, if it has one
+inline void EpochIndex::erase(ID id)
+{
+	ID slot = slotOf(id);
+	if(slot >= entries.size() || entries[slot].id != id)
+	{
+		return;
+	}
+	entries[slot].epoch = epoch - 1;
+}
+
+// removes all entries by moving on to the next epoch. the array is only
+// actually touched when the epoch counter wraps around.
+inline void EpochIndex::clear()
+{
+	epoch++;
+	if(epoch == 0)
+	{
+		for(auto& entry : entries)
+		{
+			entry.epoch = 0;
+		}
+		epoch = 1;
+	}
+}
+
+// returns the number of ID slots the index has room for
+inline size_t EpochIndex::slots() const
+{
+	return entries.size();
+}
+
+// returns the memory allocated by the index
+inline size_t EpochIndex::bytes() const
+{
+	return entries.capacity() * sizeof(Entry);
+}
+
+}
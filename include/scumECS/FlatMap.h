@@ -0,0 +1,592 @@
+#pragma once
+
+#include "Types.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <memory_resource>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+	(defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SCUM_HAS_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace scum
+{
+
+// maps IDs to values with open addressing, probing sixteen slots at a time
+// as in SwissTable. each slot has a control byte holding seven bits of its
+// key's hash, and a probe compares a group's control bytes against the
+// wanted hash with one SSE2 instruction (or a scalar loop without SSE2),
+// only touching the entries whose hashes match. provides the subset of the
+// robin_map interface that pools use (see EntityMap). values must be
+// trivially copyable.
+//
+// growing doesn't rehash every entry at once. the full table is kept and
+// a new one allocated, then each later insertion or erasure moves a couple
+// of groups of sixteen slots across, so no single call does more than a
+// bounded amount of work. lookups check both tables until the old one is
+// empty. reserve(), rehash() and copying still move everything at once.
+// this is only used when SCUM_LOOKUP_BACKEND is SCUM_LOOKUP_FLAT (see
+// EntityMap); the default backend rehashes all at once.
+template<typename V>
+class FlatMap
+{
+public:
+	struct Entry
+	{
+		ID first;
+		V second;
+	};
+
+	using value_type = Entry;
+	using allocator_type = std::pmr::polymorphic_allocator<Entry>;
+	using iterator = Entry*;
+	using const_iterator = const Entry*;
+
+	explicit FlatMap(const allocator_type& allocator = allocator_type());
+	FlatMap(const FlatMap& other);
+	FlatMap& operator=(const FlatMap& other);
+	~FlatMap();
+
+	iterator find(ID id);
+	const_iterator find(ID id) const;
+	void prefetch(ID id) const;
+	iterator end();
+	const_iterator end() const;
+	V& operator[](ID id);
+	size_t erase(ID id);
+	void clear();
+	void reserve(size_t count);
+	void rehash(size_t count);
+
+	size_t size() const;
+	size_t bucket_count() const;
+	float load_factor() const;
+	size_t bytes() const;
+	bool migrating() const;
+
+private:
+	static_assert(std::is_trivially_copyable_v<V>,
+		"FlatMap values must be trivially copyable");
+
+	static constexpr size_t GroupSize = 16;
+	static constexpr size_t Alignment =
+		alignof(Entry) > GroupSize ? alignof(Entry) : GroupSize;
+	// control bytes of slots without an entry. both have the high bit set,
+	// which hashes never do
+	static constexpr int8_t Empty = -128;
+	static constexpr int8_t Deleted = -2; // a removed entry, which probes skip
+	// groups moved out of an old table by each insertion or erasure. moving
+	// two per call finishes before a table rebuilt at the same size fills
+	static constexpr size_t MigrateGroups = 2;
+
+	// control bytes and entries for some number of groups. control bytes
+	// and entries share one block, with the control bytes first so that
+	// groups are aligned for SSE2 loads
+	struct Table
+	{
+		int8_t* control = nullptr;
+		Entry* entries = nullptr;
+		size_t groupMask = 0; // the number of groups minus one
+		size_t slots = 0;
+	};
+
+	static uint64_t hash(ID id);
+	static int8_t tag(uint64_t h);
+	static uint32_t match(const int8_t* group, int8_t byte);
+	static uint32_t matchFree(const int8_t* group);
+	static unsigned lowestBit(uint32_t mask);
+	static size_t findIn(const Table& table, ID id);
+	static size_t freeIn(const Table& table, uint64_t h);
+
+	Table allocate(size_t groups);
+	void deallocate(Table& table);
+	void place(const Entry& entry);
+	void grow(size_t groups);
+	void migrate(size_t groups);
+
+	allocator_type allocator;
+	Table table; // where new entries go
+	Table old; // the table being moved into table, if it has any slots
+	size_t migrated = 0; // groups of old which have been moved
+	size_t count = 0; // entries in both tables
+	size_t oldCount = 0; // entries still in old
+	size_t deleted = 0; // tombstones in table
+};
+
+template<typename V>
+FlatMap<V>::FlatMap(const allocator_type& allocator)
+	: allocator(allocator)
+{}
+
+template<typename V>
+FlatMap<V>::FlatMap(const FlatMap& other)
+	: allocator(other.allocator)
+{
+	*this = other;
+}
+
+// copies the other map's entries into a single table, keeping this map's
+// allocator
+template<typename V>
+FlatMap<V>& FlatMap<V>::operator=(const FlatMap& other)
+{
+	if(this == &other)
+	{
+		return *this;
+	}
+	deallocate(old);
+	if(table.slots != other.table.slots)
+	{
+		deallocate(table);
+		if(other.table.slots != 0)
+		{
+			table = allocate(other.table.groupMask + 1);
+		}
+	}
+	else if(table.slots != 0)
+	{
+		std::memset(table.control, Empty, table.slots);
+	}
+	count = 0;
+	oldCount = 0;
+	deleted = 0;
+	for(const Table* source : {&other.table, &other.old})
+	{
+		for(size_t i = 0; i < source->slots; i++)
+		{
+			if(source->control[i] >= 0)
+			{
+				place(source->entries[i]);
+			}
+		}
+	}
+	return *this;
+}
+
+template<typename V>
+FlatMap<V>::~FlatMap()
+{
+	deallocate(table);
+	deallocate(old);
+}
+
+// returns the entry for an ID, or end() if there isn't one
+template<typename V>
+typename FlatMap<V>::iterator FlatMap<V>::find(ID id)
+{
+	return const_cast<iterator>(static_cast<const FlatMap*>(this)->find(id));
+}
+
+template<typename V>
+typename FlatMap<V>::const_iterator FlatMap<V>::find(ID id) const
+{
+	size_t index = findIn(table, id);
+	if(index != table.slots)
+	{
+		return &table.entries[index];
+	}
+	if(old.slots != 0)
+	{
+		index = findIn(old, id);
+		if(index != old.slots)
+		{
+			return &old.entries[index];
+		}
+	}
+	return end();
+}
+
+// starts loading the control bytes and first entries of the group a find
+// for an ID would probe first. an old table being moved out of isn't
+// prefetched, since most entries have usually left it
+template<typename V>
+void FlatMap<V>::prefetch(ID id) const
+{
+	if(table.slots == 0)
+	{
+		return;
+	}
+	size_t group = size_t(hash(id) >> 32) & table.groupMask;
+	scum::prefetch(table.control + group * GroupSize);
+	scum::prefetch(table.entries + group * GroupSize);
+}
+
+template<typename V>
+typename FlatMap<V>::iterator FlatMap<V>::end()
+{
+	return nullptr;
+}
+
+template<typename V>
+typename FlatMap<V>::const_iterator FlatMap<V>::end() const
+{
+	return nullptr;
+}
+
+// returns the value for an ID, adding a value-initialized one if needed.
+// the reference is only valid until the map is next changed
+template<typename V>
+V& FlatMap<V>::operator[](ID id)
+{
+	migrate(MigrateGroups);
+	auto it = find(id);
+	if(it != end())
+	{
+		return it->second;
+	}
+
+	// keep at least one slot in eight empty so that probes stay short and
+	// always end. tombstones count, so a table full of them is rebuilt at
+	// the same size, as long as the entries leave room for the insertions
+	// made while they're moved across
+	size_t used = count - oldCount + deleted;
+	if((used + 1) * 8 > table.slots * 7)
+	{
+		size_t groups = table.slots == 0 ? 1 : table.groupMask + 1;
+		grow((count + 1) * 16 > table.slots * 13 ? groups * 2 : groups);
+	}
+
+	uint64_t h = hash(id);
+	size_t index = freeIn(table, h);
+	deleted -= table.control[index] == Deleted;
+	table.control[index] = tag(h);
+	table.entries[index] = Entry{id, V()};
+	count++;
+	return table.entries[index].second;
+}
+
+template<typename V>
+size_t FlatMap<V>::erase(ID id)
+{
+	migrate(MigrateGroups);
+	size_t index = findIn(table, id);
+	if(index != table.slots)
+	{
+		// probes stop at the first group with an empty slot, so if this
+		// group has one, no probe ever passed through it and the slot can be
+		// emptied outright. otherwise later probes need a tombstone
+		const int8_t* group = table.control + (index & ~(GroupSize - 1));
+		if(match(group, Empty) != 0)
+		{
+			table.control[index] = Empty;
+		}
+		else
+		{
+			table.control[index] = Deleted;
+			deleted++;
+		}
+		count--;
+		return 1;
+	}
+	if(old.slots != 0)
+	{
+		// nothing is added to the old table, so tombstones there are never
+		// reused or cleaned up
+		index = findIn(old, id);
+		if(index != old.slots)
+		{
+			old.control[index] = Deleted;
+			count--;
+			oldCount--;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+// removes every entry, keeping the memory of the current table
+template<typename V>
+void FlatMap<V>::clear()
+{
+	deallocate(old);
+	if(table.slots != 0)
+	{
+		std::memset(table.control, Empty, table.slots);
+	}
+	count = 0;
+	oldCount = 0;
+	deleted = 0;
+}
+
+// makes room for a number of entries without growing, moving everything
+// into one table immediately. a quarter of the slots are left spare, so
+// that erasing and inserting entries only ever rebuilds the table at the
+// same size
+template<typename V>
+void FlatMap<V>::reserve(size_t count)
+{
+	migrate(old.groupMask + 1);
+	size_t groups = table.slots == 0 ? 1 : table.groupMask + 1;
+	while(count * 4 > groups * GroupSize * 3)
+	{
+		groups *= 2;
+	}
+	if(groups * GroupSize > table.slots)
+	{
+		grow(groups);
+		migrate(old.groupMask + 1);
+	}
+}
+
+// rebuilds the table at the smallest size which holds its entries, or the
+// given number of entries if that's more, with the same spare quarter as
+// reserve(). this drops tombstones, and rehash(0) on an empty map frees
+// the table entirely
+template<typename V>
+void FlatMap<V>::rehash(size_t count)
+{
+	migrate(old.groupMask + 1);
+	count = std::max(count, size());
+	if(count == 0)
+	{
+		deallocate(table);
+		deleted = 0;
+		return;
+	}
+	size_t groups = 1;
+	while(count * 4 > groups * GroupSize * 3)
+	{
+		groups *= 2;
+	}
+	if(groups * GroupSize != table.slots || deleted != 0)
+	{
+		grow(groups);
+		migrate(old.groupMask + 1);
+	}
+}
+
+template<typename V>
+size_t FlatMap<V>::size() const
+{
+	return count;
+}
+
+template<typename V>
+size_t FlatMap<V>::bucket_count() const
+{
+	return table.slots;
+}
+
+template<typename V>
+float FlatMap<V>::load_factor() const
+{
+	return table.slots == 0 ? 0.0f : float(count) / table.slots;
+}
+
+// returns the memory allocated by the map, counting a table being moved
+template<typename V>
+size_t FlatMap<V>::bytes() const
+{
+	return (table.slots + old.slots) * (1 + sizeof(Entry));
+}
+
+// returns true if entries are still being moved out of an old table
+template<typename V>
+bool FlatMap<V>::migrating() const
+{
+	return old.slots != 0;
+}
+
+// spreads IDHash over all 64 bits. the group comes from the high half and
+// the control byte from bits below it, so the two are independent
+template<typename V>
+uint64_t FlatMap<V>::hash(ID id)
+{
+	return uint64_t(IDHash()(id)) * 0x9e3779b97f4a7c15ull;
+}
+
+// returns the control byte for a full slot with the given hash
+template<typename V>
+int8_t FlatMap<V>::tag(uint64_t h)
+{
+	return int8_t((h >> 25) & 0x7f);
+}
+
+// returns a mask with a bit set for each control byte in the group equal
+// to byte
+template<typename V>
+uint32_t FlatMap<V>::match(const int8_t* group, int8_t byte)
+{
+#ifdef SCUM_HAS_SSE2
+	__m128i bytes = _mm_load_si128(reinterpret_cast<const __m128i*>(group));
+	return uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes,
+		_mm_set1_epi8(byte))));
+#else
+	uint32_t mask = 0;
+	for(size_t i = 0; i < GroupSize; i++)
+	{
+		mask |= uint32_t(group[i] == byte) << i;
+	}
+	return mask;
+#endif
+}
+
+// returns a mask with a bit set for each empty or deleted slot in the group
+template<typename V>
+uint32_t FlatMap<V>::matchFree(const int8_t* group)
+{
+#ifdef SCUM_HAS_SSE2
+	__m128i bytes = _mm_load_si128(reinterpret_cast<const __m128i*>(group));
+	return uint32_t(_mm_movemask_epi8(bytes));
+#else
+	uint32_t mask = 0;
+	for(size_t i = 0; i < GroupSize; i++)
+	{
+		mask |= uint32_t(group[i] < 0) << i;
+	}
+	return mask;
+#endif
+}
+
+// returns the index of the lowest set bit. mask must not be zero
+template<typename V>
+unsigned FlatMap<V>::lowestBit(uint32_t mask)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return unsigned(index);
+#else
+	return unsigned(__builtin_ctz(mask));
+#endif
+}
+
+// returns the slot holding an ID in a table, or the table's size if it
+// isn't there. probes visit groups in triangular steps, which covers every
+// group when the number of groups is a power of two
+template<typename V>
+size_t FlatMap<V>::findIn(const Table& table, ID id)
+{
+	if(table.slots == 0)
+	{
+		return table.slots;
+	}
+	uint64_t h = hash(id);
+	int8_t wanted = tag(h);
+	size_t group = size_t(h >> 32) & table.groupMask;
+	for(size_t step = 1; ; step++)
+	{
+		const int8_t* bytes = table.control + group * GroupSize;
+		for(uint32_t mask = match(bytes, wanted); mask != 0; mask &= mask - 1)
+		{
+			size_t index = group * GroupSize + lowestBit(mask);
+			if(table.entries[index].first == id)
+			{
+				return index;
+			}
+		}
+		if(match(bytes, Empty) != 0 || step > table.groupMask)
+		{
+			return table.slots;
+		}
+		group = (group + step) & table.groupMask;
+	}
+}
+
+// returns the first empty or deleted slot along a hash's probe sequence.
+// the table must have one
+template<typename V>
+size_t FlatMap<V>::freeIn(const Table& table, uint64_t h)
+{
+	size_t group = size_t(h >> 32) & table.groupMask;
+	for(size_t step = 1; ; step++)
+	{
+		uint32_t mask = matchFree(table.control + group * GroupSize);
+		if(mask != 0)
+		{
+			return group * GroupSize + lowestBit(mask);
+		}
+		group = (group + step) & table.groupMask;
+	}
+}
+
+template<typename V>
+typename FlatMap<V>::Table FlatMap<V>::allocate(size_t groups)
+{
+	Table result;
+	result.slots = groups * GroupSize;
+	result.groupMask = groups - 1;
+	void* block = allocator.resource()->allocate(
+		result.slots * (1 + sizeof(Entry)), Alignment);
+	result.control = static_cast<int8_t*>(block);
+	result.entries = reinterpret_cast<Entry*>(result.control + result.slots);
+	std::memset(result.control, Empty, result.slots);
+	return result;
+}
+
+template<typename V>
+void FlatMap<V>::deallocate(Table& table)
+{
+	if(table.slots != 0)
+	{
+		allocator.resource()->deallocate(table.control,
+			table.slots * (1 + sizeof(Entry)), Alignment);
+	}
+	table = Table();
+}
+
+// adds an entry which isn't in the map to the current table, which must
+// have room for it
+template<typename V>
+void FlatMap<V>::place(const Entry& entry)
+{
+	uint64_t h = hash(entry.first);
+	size_t index = freeIn(table, h);
+	table.control[index] = tag(h);
+	table.entries[index] = entry;
+	count++;
+}
+
+// starts moving every entry into a new table with the given number of
+// groups, which drops tombstones along the way. a move which is still
+// going is finished first
+template<typename V>
+void FlatMap<V>::grow(size_t groups)
+{
+	migrate(old.groupMask + 1);
+	old = table;
+	table = allocate(groups);
+	migrated = 0;
+	oldCount = count;
+	deleted = 0;
+}
+
+// moves up to the given number of groups from the old table into the
+// current one, freeing the old table once it's empty. moved slots are
+// marked as deleted so that probes in the old table still pass them
+template<typename V>
+void FlatMap<V>::migrate(size_t groups)
+{
+	if(old.slots == 0)
+	{
+		return;
+	}
+	size_t end = std::min(migrated + groups, old.groupMask + 1);
+	for(size_t i = migrated * GroupSize; i < end * GroupSize; i++)
+	{
+		if(old.control[i] >= 0)
+		{
+			old.control[i] = Deleted;
+			count--;
+			oldCount--;
+			place(old.entries[i]);
+		}
+	}
+	migrated = end;
+	if(migrated > old.groupMask)
+	{
+		deallocate(old);
+	}
+}
+
+}
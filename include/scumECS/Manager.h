@@ -2,6 +2,15 @@
 
 #include "Types.h"
 #include "Pool.h"
+#include "Snapshot.h"
+#include "CommandLog.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <memory_resource>
+#include <string>
 #include <vector>
 
 namespace scum
@@ -12,13 +21,19 @@ class Search;
 class Entity;
 
 // the core class of the entity system. contains a set of pools, each of which
-// contains components of a particular type. also manages entity IDs
+// contains components of a particular type. also manages entity IDs.
+// all of the manager's memory, including pools, lookup tables, and queues,
+// is allocated from the given memory resource.
 class Manager
 {
 public:
-	Manager();
+	explicit Manager(std::pmr::memory_resource* resource
+		= std::pmr::get_default_resource());
+	Manager(Manager&& other);
 	~Manager();
 
+	Manager fork(std::pmr::memory_resource* resource = nullptr) const;
+
 	ID newID();
 	Entity newEntity();
 
@@ -33,25 +48,138 @@ public:
 	void queueDestroy(ID id);
 	void processQueues();
 
+	void disable(ID id);
+	void enable(ID id);
+	bool isEnabled(ID id) const;
+
+	template<typename KeyFn>
+	bool defragment(KeyFn key, std::chrono::nanoseconds budget
+		= std::chrono::nanoseconds::max());
+	bool defragment(std::chrono::nanoseconds budget
+		= std::chrono::nanoseconds::max());
+
+	bool save(const std::string& path) const;
+	bool save(SnapshotWriter& out) const;
+	BackgroundSave saveInBackground(const std::string& path) const;
+	bool load(const std::string& path);
+	bool load(SnapshotReader& in, bool adopt = false);
+
+	uint64_t checksum() const;
+	ManagerStats stats() const;
+
+	void reserveEntities(size_t count, size_t queued = 0);
 	template<typename C>
-	bool contains(ID id);
+	void reserve(size_t count, size_t queued = 0);
+	void shrinkToFit();
+	void setBudget(size_t entities, size_t queued);
+	template<typename C>
+	void setBudget(size_t count, size_t queued);
+
+	void record(CommandLog* log);
+	bool replay(const CommandLog& log);
+
+	template<typename C>
+	bool contains(ID id) const;
 	template<typename C>
 	C* get(ID id);
 	template<typename C>
+	const C* get(ID id) const;
+	template<typename C>
 	C* tryGet(ID id);
 	template<typename C>
+	const C* tryGet(ID id) const;
+	template<typename C>
+	void getMany(const ID* ids, size_t count, C** out);
+	template<typename C>
+	void getMany(const ID* ids, size_t count, const C** out) const;
+	template<typename C>
 	Pool<C>& getPool();
+	template<typename C>
+	const Pool<C>& getPool() const;
 
 	template<typename... Cs>
-	Search<Cs...> search();
+	Search<Cs...> search() const;
+
+	std::pmr::memory_resource* resource() const;
 
 private:
-	std::vector<PoolBase*> pools;
+	Manager(const Manager& parent, std::pmr::memory_resource* resource);
+
+	const PoolBase* findPool(size_t type) const;
+	void dropParent();
+	template<typename Pred>
+	void forkPools(Pred pred);
+	template<typename Fn>
+	void forEachPool(Fn fn) const;
+	bool replayOps(const CommandLog& log);
+
+	std::pmr::memory_resource* memory;
+	std::pmr::vector<PoolBase*> pools;
 	AssocContainer<size_t, size_t> lookupTable;
-	std::vector<ID> freeIDs;
+	std::pmr::vector<ID> freeIDs;
 	ID nextID = 0; // the ID counter starts at 1; 0 is reserved as "Null"
 
-	std::vector<ID> destroyQueue;
+	std::pmr::vector<ID> destroyQueue;
+
+	// indexed by ID slot. holds the disabled ID in that slot, or Null
+	std::pmr::vector<ID> disabledIDs;
+	// queued additions for disabled entities, to be disabled once applied
+	std::pmr::vector<std::pair<PoolBase*, ID>> disableQueue;
+
+	// progress of an incremental defragment pass. each pool's entities are
+	// keyed, sorted in runs, merged and then placed, a chunk at a time
+	struct DefragState
+	{
+		enum Phase
+		{
+			Keying,
+			Sorting, // sorting runs of chunk entries each
+			Merging,
+			Placing
+		};
+		// the most entries each step works on before the clock is checked
+		static constexpr size_t chunk = 1024;
+
+		struct Keyed
+		{
+			uint64_t key;
+			ID id;
+		};
+
+		explicit DefragState(std::pmr::memory_resource* resource);
+		void reset();
+
+		size_t pool = 0; // the pool currently being reordered
+		Phase phase = Keying;
+		size_t count = 0; // entities keyed from the pool
+		size_t next = 0; // the next entry to key, sort, or place, or the
+			// start of the runs being merged
+		size_t width = 0; // the length of the runs being merged
+		size_t left = 0; // the next entry of each run being merged
+		size_t right = 0;
+		size_t placed = 0; // components already in position in the pool
+		// keys and IDs of the pool's entities. scratch is merged into
+		std::pmr::vector<Keyed> keys;
+		std::pmr::vector<Keyed> scratch;
+		std::pmr::vector<ID> order; // a chunk of IDs being placed
+	};
+	DefragState defrag;
+
+	// the last snapshot file loaded, whose arrays pools may have adopted
+	MappedFile mapping;
+
+	// the manager this one was forked from, whose pools are read until
+	// they're first changed and copied, or nullptr
+	const Manager* parent = nullptr;
+	// forks which still read this manager's pools
+	mutable size_t forks = 0;
+
+	// where operations are being recorded, or nullptr
+	CommandLog* log = nullptr;
+
+	// limits set by setBudget, or 0 if the manager has none
+	size_t entityBudget = 0;
+	size_t queueBudget = 0;
 };
 
 }
@@ -62,34 +190,103 @@ private:
 namespace scum
 {
 
-inline Manager::Manager()
+inline Manager::Manager(std::pmr::memory_resource* resource)
+	: memory(resource), pools(resource),
+	lookupTable(AssocContainer<size_t, size_t>::allocator_type(resource)),
+	freeIDs(resource), destroyQueue(resource), disabledIDs(resource),
+	disableQueue(resource), defrag(resource)
 {
 	freeIDs.push_back(nextID + 1); // add "1" as the first free ID
 }
 
+// creates a fork of a manager. see fork()
+inline Manager::Manager(const Manager& parent,
+	std::pmr::memory_resource* resource)
+	: Manager(resource)
+{
+	this->parent = &parent;
+	parent.forks++;
+	freeIDs = parent.freeIDs;
+	nextID = parent.nextID;
+	disabledIDs = parent.disabledIDs;
+	if(parent.entityBudget != 0)
+	{
+		setBudget(parent.entityBudget, parent.queueBudget);
+	}
+}
+
+// takes over another manager's pools and entities, leaving it empty.
+// managers with forks can't be moved, since the forks point at them
+inline Manager::Manager(Manager&& other)
+	: memory(other.memory), pools(std::move(other.pools)),
+	lookupTable(std::move(other.lookupTable)),
+	freeIDs(std::move(other.freeIDs)), nextID(other.nextID),
+	destroyQueue(std::move(other.destroyQueue)),
+	disabledIDs(std::move(other.disabledIDs)),
+	disableQueue(std::move(other.disableQueue)),
+	defrag(std::move(other.defrag)), mapping(std::move(other.mapping)),
+	parent(other.parent), log(other.log), entityBudget(other.entityBudget),
+	queueBudget(other.queueBudget)
+{
+	assert(other.forks == 0);
+	other.pools.clear();
+	other.lookupTable.clear();
+	other.parent = nullptr;
+}
+
 inline Manager::~Manager()
 {
+	// forks read this manager's pools, so they must be destroyed first
+	assert(forks == 0);
+	dropParent();
 	for(auto* pool : pools)
 	{
-		delete(pool);
+		pool->dispose(memory);
 	}
 }
 
+// returns a new manager which starts out with the same entities and
+// components as this one, but can be changed independently of it. the fork
+// reads this manager's pools until it first changes one, or might (through
+// add, the non-const get or getPool, and so on), and copies it then, so
+// forking is cheap and a fork only pays for the component types it writes.
+// contains, search, and get through a const Manager never copy. destroying,
+// disabling, or enabling an entity copies the pools which contain it, and
+// defragmenting copies every pool. queued operations aren't copied.
+// this manager must outlive its forks and mustn't be changed while they
+// exist: its destructor and everything which adds, removes, destroys,
+// disables, enables, processes queues, loads or defragments assert that it
+// has none. writing through a pointer from its get isn't caught. if
+// resource is nullptr, the fork uses this manager's memory resource.
+inline Manager Manager::fork(std::pmr::memory_resource* resource) const
+{
+	return Manager(*this, resource != nullptr ? resource : memory);
+}
+
 // returns a free ID. the manager is guaranteed to return at least
 // 4,096 other IDs before recycling a given previously used ID.
 // there is a limit of 1,048,576 simultaneous unique IDs. generating new IDs
 // past that point is undefined behavior
 inline ID Manager::newID()
 {
+	ID id;
 	if(freeIDs.size() != 0)
 	{
-		ID id = freeIDs.back();
+		id = freeIDs.back();
 		freeIDs.pop_back();
-		return id;
+	}
+	else
+	{
+		nextID += IDStride;
+		id = nextID;
+		assert(entityBudget == 0 || slotOf(nextID) < entityBudget);
 	}
 
-	nextID += 4096;
-	return nextID;
+	if(log != nullptr)
+	{
+		log->record(CommandLog::NewID, id);
+	}
+	return id;
 }
 
 inline Entity Manager::newEntity()
@@ -101,26 +298,60 @@ inline Entity Manager::newEntity()
 template<typename C, typename... Args>
 C* Manager::add(ID id, Args... args)
 {
-	return getPool<C>().add(id, std::forward<Args>(args)...);
+	assert(forks == 0);
+	auto& pool = getPool<C>();
+	C* component = pool.add(id, std::forward<Args>(args)...);
+	if(!isEnabled(id))
+	{
+		pool.disable(id);
+		component = pool.get(id);
+	}
+	if(log != nullptr)
+	{
+		log->record(CommandLog::Add, id, *component);
+	}
+	return component;
 }
 
 // queues a component for addition to an entity
 template<typename C, typename... Args>
 C* Manager::queueAdd(ID id, Args... args)
 {
-	return getPool<C>().queueAdd(id, std::forward<Args>(args)...);
+	assert(forks == 0);
+	auto& pool = getPool<C>();
+	if(!isEnabled(id))
+	{
+		disableQueue.emplace_back(&pool, id);
+	}
+	C* component = pool.queueAdd(id, std::forward<Args>(args)...);
+	if(log != nullptr)
+	{
+		log->record(CommandLog::QueueAdd, id, *component);
+	}
+	return component;
 }
 
 // removes a component from an entity
 template<typename C>
 void Manager::remove(ID id)
 {
+	assert(forks == 0);
 	getPool<C>().remove(id);
+	if(log != nullptr)
+	{
+		log->recordType<C>(CommandLog::Remove, id);
+	}
 }
 
 // removes all components from an entity, then frees the ID
 inline void Manager::destroy(ID id)
 {
+	assert(forks == 0);
+	if(log != nullptr)
+	{
+		log->record(CommandLog::Destroy, id);
+	}
+	forkPools([id](const PoolBase& pool) { return pool.contains(id); });
 	for(auto pool : pools)
 	{
 		if(pool->contains(id))
@@ -128,9 +359,13 @@ inline void Manager::destroy(ID id)
 			pool->remove(id);
 		}
 	}
+	if(!isEnabled(id))
+	{
+		disabledIDs[slotOf(id)] = Null;
+	}
 
 	id++;
-	if((id & (4096 - 1)) != 0) // equivalent to id % 4096
+	if((id & (IDStride - 1)) != 0) // equivalent to id % IDStride
 	{
 		freeIDs.push_back(id);
 	}
@@ -139,42 +374,910 @@ inline void Manager::destroy(ID id)
 // queues a component for destruction
 inline void Manager::queueDestroy(ID id)
 {
+	assert(forks == 0);
+	assert(entityBudget == 0 || destroyQueue.size() < queueBudget);
 	destroyQueue.push_back(id);
+	if(log != nullptr)
+	{
+		log->record(CommandLog::QueueDestroy, id);
+	}
 }
 
 // applies all queued additions, removals, and destructions for all pools
 inline void Manager::processQueues()
 {
+	SCUM_PROFILE_SCOPE("scum::Manager::processQueues");
+	assert(forks == 0);
+	// queued operations were recorded when they were queued
+	CommandLog* recording = log;
+	if(log != nullptr)
+	{
+		log->record(CommandLog::ProcessQueues, Null);
+		log = nullptr;
+	}
+	// transient pools are emptied even if the fork hasn't used them
+	forkPools([](const PoolBase& pool) { return pool.isTransient(); });
 	for(auto* pool : pools)
 	{
 		pool->processQueues();
 	}
+	// the entity may have been enabled again since the addition was queued
+	for(auto& [pool, id] : disableQueue)
+	{
+		if(!isEnabled(id))
+		{
+			pool->disable(id);
+		}
+	}
+	disableQueue.clear();
 	for(auto& id : destroyQueue)
 	{
 		destroy(id);
 	}
 	destroyQueue.clear();
+	log = recording;
+}
+
+// disables all of an entity's components, which moves them out of the way
+// of iteration and searches without removing them. components added to the
+// entity while it is disabled start out disabled too.
+inline void Manager::disable(ID id)
+{
+	assert(forks == 0);
+	if(log != nullptr)
+	{
+		log->record(CommandLog::Disable, id);
+	}
+	ID slot = slotOf(id);
+	if(slot >= disabledIDs.size())
+	{
+		disabledIDs.resize(slot + 1, Null);
+	}
+	disabledIDs[slot] = id;
+	forkPools([id](const PoolBase& pool) { return pool.contains(id); });
+	for(auto* pool : pools)
+	{
+		if(pool->contains(id))
+		{
+			pool->disable(id);
+		}
+	}
+}
+
+// re-enables all of an entity's components
+inline void Manager::enable(ID id)
+{
+	assert(forks == 0);
+	if(isEnabled(id))
+	{
+		return;
+	}
+	if(log != nullptr)
+	{
+		log->record(CommandLog::Enable, id);
+	}
+	disabledIDs[slotOf(id)] = Null;
+	forkPools([id](const PoolBase& pool) { return pool.contains(id); });
+	for(auto* pool : pools)
+	{
+		if(pool->contains(id))
+		{
+			pool->enable(id);
+		}
+	}
+}
+
+// checks if an entity is enabled. entities start out enabled.
+inline bool Manager::isEnabled(ID id) const
+{
+	ID slot = slotOf(id);
+	return slot >= disabledIDs.size() || disabledIDs[slot] != id;
+}
+
+inline Manager::DefragState::DefragState(std::pmr::memory_resource* resource)
+	: keys(resource), scratch(resource), order(resource)
+{}
+
+// abandons the pass in progress, keeping the buffers' memory
+inline void Manager::DefragState::reset()
+{
+	pool = 0;
+	phase = Keying;
+	next = 0;
+	placed = 0;
+}
+
+// reorders the enabled components of every pool by a key computed from
+// each entity's ID, so that related entities sit next to each other in all
+// pools. the key is an unsigned integer of up to 64 bits, such as the slot
+// or a spatial Morton code. each pool is keyed, sorted and placed a chunk of
+// entities at a time, and work stops once the time budget runs out and
+// resumes on the next call, so a pass can be spread over several frames.
+// the same key function should be passed to every call of a pass. pools can
+// be changed between calls, which just leaves them less ordered. returns
+// true when a pass over every pool has been completed.
+template<typename KeyFn>
+bool Manager::defragment(KeyFn key, std::chrono::nanoseconds budget)
+{
+	SCUM_PROFILE_SCOPE("scum::Manager::defragment");
+	assert(forks == 0);
+	using Key = decltype(key(ID()));
+	static_assert(std::is_unsigned_v<Key> && sizeof(Key) <= sizeof(uint64_t),
+		"defragment keys must be unsigned integers of up to 64 bits");
+	using Keyed = DefragState::Keyed;
+	auto less = [](const Keyed& l, const Keyed& r)
+	{
+		return l.key < r.key || (l.key == r.key && l.id < r.id);
+	};
+	const size_t chunk = DefragState::chunk;
+	auto start = std::chrono::steady_clock::now();
+	forkPools([](const PoolBase&) { return true; });
+	dropParent();
+
+	auto& d = defrag;
+	while(d.pool < pools.size())
+	{
+		PoolBase* pool = pools[d.pool];
+		Keyed* keys = d.keys.data();
+		if(pool->isTransient())
+		{
+			d.pool++;
+			continue;
+		}
+
+		if(d.phase == DefragState::Keying)
+		{
+			if(d.next == 0)
+			{
+				d.count = pool->activeSize();
+				d.keys.resize(d.count);
+				d.scratch.resize(d.count);
+				keys = d.keys.data();
+			}
+			// the pool may have lost components since the pass started
+			d.count = std::min(d.count, size_t(pool->activeSize()));
+			d.next = std::min(d.next, d.count);
+			// an empty pool has nothing to place, and no first entity to
+			// take the address of
+			if(d.count == 0)
+			{
+				size_t next = d.pool + 1;
+				d.reset();
+				d.pool = next;
+				continue;
+			}
+			size_t end = std::min(d.next + chunk, d.count);
+			const ID* ids = &*pool->entityBegin();
+			for(; d.next < end; d.next++)
+			{
+				keys[d.next] = Keyed{key(ids[d.next]), ids[d.next]};
+			}
+			if(d.next == d.count)
+			{
+				d.phase = DefragState::Sorting;
+				d.next = 0;
+			}
+		}
+		else if(d.phase == DefragState::Sorting)
+		{
+			size_t end = std::min(d.next + chunk, d.count);
+			std::sort(keys + d.next, keys + end, less);
+			d.next = end;
+			if(d.next == d.count)
+			{
+				d.phase = chunk < d.count ? DefragState::Merging :
+					DefragState::Placing;
+				d.next = 0;
+				d.width = chunk;
+				d.left = 0;
+				d.right = std::min(chunk, d.count);
+			}
+		}
+		else if(d.phase == DefragState::Merging)
+		{
+			// merges two neighbouring runs into scratch, stopping after a
+			// chunk of entries and carrying on from there next time
+			Keyed* merged = d.scratch.data();
+			size_t mid = std::min(d.next + d.width, d.count);
+			size_t end = std::min(d.next + 2 * d.width, d.count);
+			for(size_t i = 0; i < chunk && (d.left < mid || d.right < end); i++)
+			{
+				size_t out = d.left + d.right - mid;
+				if(d.right == end ||
+					(d.left < mid && !less(keys[d.right], keys[d.left])))
+				{
+					merged[out] = keys[d.left++];
+				}
+				else
+				{
+					merged[out] = keys[d.right++];
+				}
+			}
+			if(d.left == mid && d.right == end)
+			{
+				d.next = end;
+				if(d.next == d.count)
+				{
+					std::swap(d.keys, d.scratch);
+					d.width *= 2;
+					d.next = 0;
+				}
+				if(d.width >= d.count)
+				{
+					d.phase = DefragState::Placing;
+					d.next = 0;
+				}
+				d.left = d.next;
+				d.right = std::min(d.next + d.width, d.count);
+			}
+		}
+		else
+		{
+			size_t end = std::min(d.next + chunk, d.count);
+			d.order.clear();
+			for(size_t i = d.next; i < end; i++)
+			{
+				d.order.push_back(keys[i].id);
+			}
+			d.placed = pool->placeInOrder(d.order.data(), d.order.size(),
+				d.placed);
+			d.next = end;
+			if(d.next == d.count)
+			{
+				size_t next = d.pool + 1;
+				d.reset();
+				d.pool = next;
+			}
+		}
+
+		if(d.pool < pools.size() &&
+			std::chrono::steady_clock::now() - start >= budget)
+		{
+			return false;
+		}
+	}
+
+	d.reset();
+	return true;
+}
+
+// defragments every pool by entity slot, which restores the order
+// entities were originally created in
+inline bool Manager::defragment(std::chrono::nanoseconds budget)
+{
+	return defragment(slotOf, budget);
+}
+
+// writes the state of the manager to a snapshot file. see save(SnapshotWriter&)
+inline bool Manager::save(const std::string& path) const
+{
+	std::FILE* file = std::fopen(path.c_str(), "wb");
+	if(file == nullptr)
+	{
+		return false;
+	}
+	SnapshotWriter out(file);
+	bool ok = save(out);
+	ok = (std::fclose(file) == 0) && ok;
+	return ok;
+}
+
+// writes all pools, IDs, and enabled states to a snapshot. returns false
+// if a non-empty pool's component type can't be saved (see Serializer) or
+// writing fails. queued operations are not saved.
+inline bool Manager::save(SnapshotWriter& out) const
+{
+	SCUM_PROFILE_SCOPE("scum::Manager::save");
+	uint64_t poolCount = 0;
+	bool saveable = true;
+	forEachPool([&](const PoolBase* pool)
+	{
+		if(pool->type()->canSnapshot)
+		{
+			poolCount++;
+		}
+		else if(pool->size() != 0)
+		{
+			saveable = false;
+		}
+	});
+	if(!saveable)
+	{
+		return false;
+	}
+	uint64_t disabledCount = 0;
+	for(auto id : disabledIDs)
+	{
+		disabledCount += (id != Null);
+	}
+
+	out.writeValue(SnapshotHeader{SnapshotMagic, SnapshotVersion, poolCount,
+		freeIDs.size(), disabledCount, nextID, 0});
+	out.pad();
+	out.write(freeIDs.data(), freeIDs.size() * sizeof(ID));
+	out.pad();
+	for(auto id : disabledIDs)
+	{
+		if(id != Null)
+		{
+			out.writeValue(id);
+		}
+	}
+	out.pad();
+	forEachPool([&](const PoolBase* pool)
+	{
+		if(pool->type()->canSnapshot)
+		{
+			pool->save(out);
+		}
+	});
+	return out.good();
+}
+
+// writes a snapshot file of the manager's current state while the program
+// carries on. the process is forked, so the child process keeps a
+// copy-on-write view of memory as it was when this was called, and writes
+// it out through a large buffer with big sequential writes. the snapshot is
+// written to a temporary file which is renamed to path once complete, so
+// path never holds a partial snapshot. the child only runs the calling
+// thread, and pools with a Serializer allocate while writing, which can
+// deadlock if another thread held the allocator's lock at the time of the
+// fork. where fork isn't available, the snapshot is written before
+// returning.
+inline BackgroundSave Manager::saveInBackground(const std::string& path) const
+{
+	BackgroundSave job;
+#ifdef SCUM_HAS_FORK
+	const size_t bufferSize = 4 << 20;
+	std::string temp = path + ".tmp";
+	std::FILE* file = std::fopen(temp.c_str(), "wb");
+	if(file == nullptr)
+	{
+		return job;
+	}
+	std::vector<char> buffer(bufferSize);
+	std::setvbuf(file, buffer.data(), _IOFBF, buffer.size());
+
+	pid_t child = ::fork();
+	if(child == 0)
+	{
+		SnapshotWriter out(file);
+		bool ok = save(out) && std::fflush(file) == 0 &&
+			std::rename(temp.c_str(), path.c_str()) == 0;
+		_exit(ok ? 0 : 1);
+	}
+	// nothing has been written through this process's copy of the file
+	std::fclose(file);
+	if(child < 0)
+	{
+		std::remove(temp.c_str());
+		return job;
+	}
+	job.process = child;
+	job.finished = false;
+	job.tempPath = std::move(temp);
+#else
+	job.ok = save(path);
+#endif
+	return job;
+}
+
+// replaces the state of the manager with a snapshot file. where possible,
+// the file is mapped into memory and pools use its arrays in place rather
+// than copying them. returns false if the file can't be read or is invalid,
+// in which case the manager is left unchanged.
+inline bool Manager::load(const std::string& path)
+{
+	// forks may be reading arrays in the current mapping
+	assert(forks == 0);
+	MappedFile file;
+	if(!file.open(path))
+	{
+		return false;
+	}
+	// pools may adopt arrays from the new mapping as soon as they load, so
+	// it's kept from then on. moving it doesn't move the data
+	MappedFile previous = std::move(mapping);
+	mapping = std::move(file);
+	SnapshotReader in(mapping.data(), mapping.size());
+	if(!load(in, true))
+	{
+		// nothing was changed, so pools may still use the previous mapping
+		mapping = std::move(previous);
+		return false;
+	}
+	// the previous mapping is no longer used by any pool
+	return true;
+}
+
+// replaces the state of the manager with a snapshot. pools which aren't in
+// the snapshot are emptied, and pending queues are discarded. if adopt is
+// true, raw arrays are used in place, so the snapshot data must stay valid
+// and writable for as long as the pools use it. the snapshot layout is checked
+// before anything is changed, and false is returned if it is invalid or
+// contains a component type the program doesn't use.
+inline bool Manager::load(SnapshotReader& in, bool adopt)
+{
+	SCUM_PROFILE_SCOPE("scum::Manager::load");
+	assert(forks == 0);
+	SnapshotReader check = in;
+	// counts come from the file, so they're compared against what's left
+	// of it before being multiplied, which can't then overflow
+	auto fits = [&check](uint64_t count, size_t elementSize)
+	{
+		return count <= check.remaining() / elementSize;
+	};
+	auto header = check.readValue<SnapshotHeader>();
+	if(header.magic != SnapshotMagic || header.version != SnapshotVersion)
+	{
+		return false;
+	}
+	check.pad();
+	if(!fits(header.freeIDCount, sizeof(ID)))
+	{
+		return false;
+	}
+	check.skip(header.freeIDCount * sizeof(ID));
+	check.pad();
+	if(!fits(header.disabledIDCount, sizeof(ID)))
+	{
+		return false;
+	}
+	check.skip(header.disabledIDCount * sizeof(ID));
+	check.pad();
+	for(uint64_t i = 0; i < header.poolCount && check.good(); i++)
+	{
+		auto poolHeader = check.readValue<PoolHeader>();
+		const TypeInfo* info = TypeRegistry::find(poolHeader.type);
+		if(info == nullptr || !info->canSnapshot ||
+			info->size != poolHeader.componentSize ||
+			info->rawSnapshot != static_cast<bool>(poolHeader.raw) ||
+			poolHeader.active > poolHeader.count)
+		{
+			return false;
+		}
+		check.pad();
+		if(!fits(poolHeader.count, sizeof(ID)))
+		{
+			return false;
+		}
+		check.skip(poolHeader.count * sizeof(ID));
+		check.pad();
+		if(poolHeader.componentBytes > check.remaining())
+		{
+			return false;
+		}
+		SnapshotReader components(check.take(poolHeader.componentBytes),
+			poolHeader.componentBytes);
+		if(info->rawSnapshot)
+		{
+			if(poolHeader.count > poolHeader.componentBytes / info->size ||
+				poolHeader.componentBytes != poolHeader.count * info->size)
+			{
+				return false;
+			}
+		}
+		else
+		{
+			// each serialized component is a length and that many bytes
+			for(uint64_t j = 0; j < poolHeader.count; j++)
+			{
+				uint32_t length = components.readValue<uint32_t>();
+				components.skip(length);
+			}
+			if(!components.good())
+			{
+				return false;
+			}
+		}
+		check.pad();
+	}
+	if(!check.good())
+	{
+		return false;
+	}
+
+	// pools the snapshot doesn't contain end up empty rather than forked
+	dropParent();
+	destroyQueue.clear();
+	disableQueue.clear();
+	defrag.reset();
+
+	in.readValue<SnapshotHeader>();
+	in.pad();
+	auto* free = reinterpret_cast<const ID*>
+		(in.take(header.freeIDCount * sizeof(ID)));
+	freeIDs.assign(free, free + header.freeIDCount);
+	in.pad();
+	disabledIDs.clear();
+	for(uint64_t i = 0; i < header.disabledIDCount; i++)
+	{
+		ID id = in.readValue<ID>();
+		if(slotOf(id) >= disabledIDs.size())
+		{
+			disabledIDs.resize(slotOf(id) + 1, Null);
+		}
+		disabledIDs[slotOf(id)] = id;
+	}
+	in.pad();
+	nextID = header.nextID;
+
+	// everything pools check has been checked above, so none of them fail.
+	// pools are replaced rather than cleared first, so that they can keep
+	// the index entries which are still right
+	SnapshotReader poolSections = in;
+	for(uint64_t i = 0; i < header.poolCount; i++)
+	{
+		auto poolHeader = in.readValue<PoolHeader>();
+		in.pad();
+		PoolBase& pool = TypeRegistry::find(poolHeader.type)->getPool(*this);
+		bool loaded = pool.load(in, poolHeader, adopt);
+		assert(loaded);
+		(void)loaded;
+	}
+	for(auto* pool : pools)
+	{
+		SnapshotReader section = poolSections;
+		bool loaded = false;
+		for(uint64_t i = 0; i < header.poolCount && !loaded; i++)
+		{
+			auto poolHeader = section.readValue<PoolHeader>();
+			loaded = poolHeader.type == pool->type()->key;
+			section.pad();
+			section.skip(poolHeader.count * sizeof(ID));
+			section.pad();
+			section.skip(poolHeader.componentBytes);
+			section.pad();
+		}
+		if(!loaded)
+		{
+			pool->clear();
+		}
+	}
+	return true;
+}
+
+// hashes the manager's IDs, enabled states, and every non-empty pool (see
+// Pool::checksum), so that two worlds which should be identical, such as
+// two lockstep peers or a world and its replay, can be compared cheaply.
+// pools are combined regardless of the order they were created in. queued
+// operations are ignored.
+inline uint64_t Manager::checksum() const
+{
+	uint64_t hash = hashBytes(freeIDs.data(), freeIDs.size() * sizeof(ID),
+		nextID);
+	for(auto id : disabledIDs)
+	{
+		if(id != Null)
+		{
+			hash = hashBytes(&id, sizeof(ID), hash);
+		}
+	}
+	uint64_t poolHashes = 0;
+	forEachPool([&](const PoolBase* pool)
+	{
+		if(pool->size() != 0)
+		{
+			poolHashes += pool->checksum();
+		}
+	});
+	return hashBytes(&poolHashes, sizeof(poolHashes), hash);
+}
+
+// reports the memory use and occupancy of the manager and every pool, for
+// tuning reserve sizes and finding pools with wasted capacity
+inline ManagerStats Manager::stats() const
+{
+	ManagerStats stats{};
+	forEachPool([&](const PoolBase* pool)
+	{
+		stats.pools.push_back(pool->stats());
+		stats.totalBytes += stats.pools.back().totalBytes;
+	});
+	stats.freeIDs = freeIDs.size();
+	stats.freeIDCapacity = freeIDs.capacity();
+	// free IDs are reused before the counter advances, so the counter only
+	// moves past the most IDs which have been in use at once. slot 0 is
+	// handed out through the initial free ID rather than the counter
+	stats.peakIDs = slotOf(nextID) + 1;
+	stats.disabledIDSlots = disabledIDs.size();
+	stats.queuedDestroys = destroyQueue.size();
+	stats.queuedDisables = disableQueue.size();
+	stats.managerBytes = pools.capacity() * sizeof(PoolBase*) +
+		(freeIDs.capacity() + destroyQueue.capacity() +
+		disabledIDs.capacity() + defrag.order.capacity()) * sizeof(ID) +
+		(defrag.keys.capacity() + defrag.scratch.capacity()) *
+		sizeof(DefragState::Keyed) +
+		disableQueue.capacity() * sizeof(std::pair<PoolBase*, ID>);
+	stats.totalBytes += stats.managerBytes;
+	return stats;
+}
+
+// makes room for a number of entities in the manager's own arrays, and for
+// a number of destructions and disables to be queued between calls to
+// processQueues. IDs themselves are just counted, so this is only needed to
+// keep recycling, disabling and defragmenting from growing anything.
+inline void Manager::reserveEntities(size_t count, size_t queued)
+{
+	freeIDs.reserve(count);
+	disabledIDs.reserve(count);
+	defrag.keys.reserve(count);
+	defrag.scratch.reserve(count);
+	defrag.order.reserve(DefragState::chunk);
+	destroyQueue.reserve(queued);
+	disableQueue.reserve(queued);
+}
+
+// makes room for a number of components of a type. see Pool::reserve
+template<typename C>
+void Manager::reserve(size_t count, size_t queued)
+{
+	getPool<C>().reserve(count, queued);
+}
+
+// frees the memory the manager and each of its pools have spare, such as
+// after a level is unloaded. pools which a fork hasn't copied from its
+// parent yet are left alone, as is anything with a budget.
+inline void Manager::shrinkToFit()
+{
+	for(auto* pool : pools)
+	{
+		pool->shrinkToFit();
+	}
+	if(entityBudget != 0)
+	{
+		return;
+	}
+	// slots past the last disabled entity are all Null, which is the same
+	// as not having them at all
+	while(!disabledIDs.empty() && disabledIDs.back() == Null)
+	{
+		disabledIDs.pop_back();
+	}
+	pools.shrink_to_fit();
+	freeIDs.shrink_to_fit();
+	disabledIDs.shrink_to_fit();
+	defrag.keys.shrink_to_fit();
+	defrag.scratch.shrink_to_fit();
+	defrag.order.shrink_to_fit();
+	destroyQueue.shrink_to_fit();
+	disableQueue.shrink_to_fit();
+}
+
+// declares the most entities which will ever exist at once, and the most
+// destructions and disables which will each be queued between calls to
+// processQueues, and reserves the manager's own memory for them now. set a
+// budget on each pool too (see Pool::setBudget) so that steady frames never
+// reallocate or rehash. exceeding a budget is a bug, which debug builds
+// catch with an assertion. forks inherit the budget.
+inline void Manager::setBudget(size_t entities, size_t queued)
+{
+	entityBudget = entities;
+	queueBudget = queued;
+	reserveEntities(entities, queued);
+}
+
+// sets a budget for a component type's pool. see Pool::setBudget
+template<typename C>
+void Manager::setBudget(size_t count, size_t queued)
+{
+	getPool<C>().setBudget(count, queued);
+}
+
+// starts recording every operation applied to the manager into a log, or
+// stops recording if log is nullptr. changes made to components through
+// pointers and references aren't recorded, so a log only rebuilds a world
+// whose components are set when they are added. to rebuild a world which
+// already existed when recording started, load a snapshot of it first.
+inline void Manager::record(CommandLog* log)
+{
+	this->log = log;
+}
+
+// applies the operations in a log, as recorded by record(). returns false
+// if the log is invalid, refers to a component type the program doesn't
+// use, or hands out different IDs than this manager does, in which case
+// the operations before the failing one have already been applied.
+// replayed operations aren't recorded.
+inline bool Manager::replay(const CommandLog& log)
+{
+	SCUM_PROFILE_SCOPE("scum::Manager::replay");
+	CommandLog* recording = this->log;
+	this->log = nullptr;
+	bool ok = replayOps(log);
+	this->log = recording;
+	return ok;
+}
+
+inline bool Manager::replayOps(const CommandLog& log)
+{
+	SnapshotReader in(log.data().data(), log.data().size());
+	while(in.remaining() != 0)
+	{
+		auto op = in.readValue<uint8_t>();
+		ID id = in.readValue<ID>();
+		PoolBase* pool = nullptr;
+		if(op == CommandLog::Add || op == CommandLog::QueueAdd ||
+			op == CommandLog::Remove)
+		{
+			const TypeInfo* info = TypeRegistry::find
+				(in.readValue<uint64_t>());
+			if(info == nullptr || !in.good())
+			{
+				return false;
+			}
+			pool = &info->getPool(*this);
+		}
+
+		switch(op)
+		{
+		case CommandLog::NewID:
+			if(newID() != id)
+			{
+				return false;
+			}
+			break;
+		case CommandLog::Add:
+		case CommandLog::QueueAdd:
+		{
+			uint32_t size = in.readValue<uint32_t>();
+			const char* data = in.take(size);
+			bool queued = op == CommandLog::QueueAdd;
+			if(data == nullptr || !pool->addRecorded(id, data, size, queued))
+			{
+				return false;
+			}
+			if(!isEnabled(id))
+			{
+				if(queued)
+				{
+					disableQueue.emplace_back(pool, id);
+				}
+				else
+				{
+					pool->disable(id);
+				}
+			}
+			break;
+		}
+		case CommandLog::Remove:
+			pool->remove(id);
+			break;
+		case CommandLog::Destroy:
+			destroy(id);
+			break;
+		case CommandLog::QueueDestroy:
+			queueDestroy(id);
+			break;
+		case CommandLog::ProcessQueues:
+			processQueues();
+			break;
+		case CommandLog::Disable:
+			disable(id);
+			break;
+		case CommandLog::Enable:
+			enable(id);
+			break;
+		default:
+			return false;
+		}
+		if(!in.good())
+		{
+			return false;
+		}
+	}
+	return true;
 }
 
 // gets and returns the pool for the specified component type.
-// will add a pool if one doesn't exist. pointers or references to pools
-// are guaranteed to remain valid for the duration of the manager's lifetime.
+// will add a pool if one doesn't exist, copying it from the parent in a
+// fork. pointers or references to pools are guaranteed to remain valid for
+// the duration of the manager's lifetime.
 template<typename C>
 Pool<C>& Manager::getPool()
 {
 	size_t type = typeid(C).hash_code();
 	if(lookupTable.find(type) == lookupTable.end())
 	{
-		pools.push_back(new Pool<C>);
+		void* mem = memory->allocate(sizeof(Pool<C>), alignof(Pool<C>));
+		auto* pool = new(mem) Pool<C>(memory);
+		pools.push_back(pool);
 		lookupTable.insert(std::pair<size_t,size_t>(type, pools.size()-1));
+		const PoolBase* source = parent != nullptr ? parent->findPool(type)
+			: nullptr;
+		if(source != nullptr)
+		{
+			pool->copy(static_cast<const Pool<C>&>(*source));
+		}
 	}
 
 	return static_cast<Pool<C>&>
 		(*(pools[lookupTable.find(type)->second]));
 }
 
+// returns the pool for a type hash, looking through the managers this one
+// was forked from if it hasn't used the type yet, or nullptr if none of
+// them have the pool
+inline const PoolBase* Manager::findPool(size_t type) const
+{
+	auto it = lookupTable.find(type);
+	if(it != lookupTable.end())
+	{
+		return pools[it->second];
+	}
+	return parent != nullptr ? parent->findPool(type) : nullptr;
+}
+
+// stops reading pools from the manager this one was forked from, once all
+// of them have been copied or replaced
+inline void Manager::dropParent()
+{
+	if(parent != nullptr)
+	{
+		parent->forks--;
+		parent = nullptr;
+	}
+}
+
+// copies the pools of the managers this one was forked from which it hasn't
+// used yet and which match a predicate
+template<typename Pred>
+void Manager::forkPools(Pred pred)
+{
+	for(auto* source = parent; source != nullptr; source = source->parent)
+	{
+		for(auto* pool : source->pools)
+		{
+			const TypeInfo* info = pool->type();
+			if(lookupTable.find(info->hash) == lookupTable.end() &&
+				findPool(info->hash) == pool && pred(*pool))
+			{
+				info->getPool(*this);
+			}
+		}
+	}
+}
+
+// calls a function with each pool the manager has, including pools of the
+// managers it was forked from which it hasn't copied yet
+template<typename Fn>
+void Manager::forEachPool(Fn fn) const
+{
+	for(auto* source = this; source != nullptr; source = source->parent)
+	{
+		for(const PoolBase* pool : source->pools)
+		{
+			if(findPool(pool->type()->hash) == pool)
+			{
+				fn(pool);
+			}
+		}
+	}
+}
+
+template<typename C>
+PoolBase& getPoolOf(Manager& manager)
+{
+	return manager.getPool<C>();
+}
+
+// returns the pool for the specified component type for reading, which
+// in a fork may be its parent's pool. if the type has no pool, returns an
+// empty one without adding it.
+template<typename C>
+const Pool<C>& Manager::getPool() const
+{
+	const PoolBase* pool = findPool(typeid(C).hash_code());
+	if(pool == nullptr)
+	{
+		static const Pool<C> empty(std::pmr::new_delete_resource());
+		return empty;
+	}
+	return static_cast<const Pool<C>&>(*pool);
+}
+
 template<typename C>
-bool Manager::contains(ID id)
+bool Manager::contains(ID id) const
 {
 	return getPool<C>().contains(id);
 }
@@ -187,6 +1290,12 @@ C* Manager::get(ID id)
 	return getPool<C>().get(id);
 }
 
+template<typename C>
+const C* Manager::get(ID id) const
+{
+	return getPool<C>().get(id);
+}
+
 // attempts to get a component for a given entity.
 // returns nullptr if the entity doesn't have the component
 template<typename C>
@@ -195,9 +1304,37 @@ C* Manager::tryGet(ID id)
 	return getPool<C>().tryGet(id);
 }
 
-// returns an entity search for the given components
+template<typename C>
+const C* Manager::tryGet(ID id) const
+{
+	return getPool<C>().tryGet(id);
+}
+
+// gets a component for each of many entities, or nullptr for those without
+// one, overlapping their lookups. see Pool::getMany
+template<typename C>
+void Manager::getMany(const ID* ids, size_t count, C** out)
+{
+	getPool<C>().getMany(ids, count, out);
+}
+
+template<typename C>
+void Manager::getMany(const ID* ids, size_t count, const C** out) const
+{
+	getPool<C>().getMany(ids, count, out);
+}
+
+// returns the memory resource the manager allocates from
+inline std::pmr::memory_resource* Manager::resource() const
+{
+	return memory;
+}
+
+// returns an entity search for the given components. searches only read
+// pools, so searching a fork reads its parent's pools for the types it
+// hasn't copied, and won't see them change if it copies them mid-search
 template<typename... Cs>
-Search<Cs...> Manager::search()
+Search<Cs...> Manager::search() const
 {
 	return Search<Cs...>(*this);
 }
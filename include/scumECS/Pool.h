@@ -1,6 +1,20 @@
 #pragma once
 
 #include "Types.h"
+#include "Storage.h"
+#include "EntityMap.h"
+#include "EpochIndex.h"
+#include "Snapshot.h"
+#include "TypeRegistry.h"
+#include "Checksum.h"
+#include "Stats.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <memory_resource>
+#include <new>
+#include <numeric>
+#include <type_traits>
 #include <vector>
 #include <typeinfo>
 #include <utility>
@@ -8,37 +22,245 @@
 namespace scum
 {
 
+// marks component types which only live until the next call to
+// processQueues, such as events or per-frame contacts. their pools are emptied
+// wholesale instead of having components removed one at a time, e.g.
+// template<> struct scum::Transient<HitEvent> : std::true_type {};
+// their pools are indexed by ID slot (see EpochIndex), so they only hold
+// IDs handed out by a Manager, never two IDs which share a slot, such as
+// small sequential IDs used with a Pool directly.
+template<typename C>
+struct Transient : std::false_type
+{};
+
 // provides a generic interface for component pools
 class PoolBase
 {
 public:
-	bool contains(ID id);
+	static constexpr size_t npos = EpochIndex::npos;
+	// how many IDs ahead batched lookups prefetch
+	static constexpr size_t lookahead = 8;
+
+	virtual ~PoolBase() = default;
+
+	bool contains(ID id) const;
+	void prefetchIndex(ID id) const;
 	void queueRemove(ID id);
 	virtual void processQueues() = 0;
 	virtual void remove(ID id) = 0;
+	virtual void dispose(std::pmr::memory_resource* resource) = 0;
+	virtual void clear() = 0;
+	virtual void shrinkToFit() = 0;
+
+	virtual bool save(SnapshotWriter& out) const = 0;
+	virtual bool load(SnapshotReader& in, const PoolHeader& header,
+		bool adopt) = 0;
+	virtual bool addRecorded(ID id, const char* data, size_t size,
+		bool queued) = 0;
+	virtual uint64_t checksum() const = 0;
+	virtual PoolStats stats() const = 0;
+
+	void disable(ID id);
+	void enable(ID id);
+	bool isEnabled(ID id);
+
+	void sortAs(PoolBase& other);
+	void applyOrder(const std::pmr::vector<size_t>& order);
+	size_t placeInOrder(const ID* ids, size_t count, size_t pos);
 
 	auto entityBegin();
 	auto entityEnd();
 	const auto entityBegin() const;
 	const auto entityEnd() const;
 	auto size() const;
+	auto activeSize() const;
+	bool isTransient() const;
+	const TypeInfo* type() const;
+	std::pmr::memory_resource* resource() const;
 
 protected:
-	AssocContainer<ID, size_t> lookupTable;
-	std::vector<ID> entities;
-	std::vector<ID> removeQueue;
+	PoolBase(std::pmr::memory_resource* resource, const TypeInfo* type,
+		bool transient);
+
+	size_t indexOf(ID id) const;
+	void setIndex(ID id, size_t index);
+	void eraseIndex(ID id);
+	void rebuildIndex();
+	void reindex(const char* ids, size_t count);
+	virtual void swapSlots(size_t a, size_t b) = 0;
+
+	const TypeInfo* const typeInfo;
+	const bool transient;
+	EntityMap<size_t> lookupTable;
+	EpochIndex epochIndex; // replaces lookupTable in transient pools
+	Storage<ID> entities;
+	std::pmr::vector<ID> removeQueue;
+	// components before this index are enabled, the rest are disabled
+	size_t active = 0;
+	size_t peak = 0; // the most components the pool has held at once
+	// limits set by Pool::setBudget, or 0 if the pool has none
+	size_t budget = 0;
+	size_t queueBudget = 0;
 };
 
+inline PoolBase::PoolBase(std::pmr::memory_resource* resource,
+	const TypeInfo* type, bool transient)
+	: typeInfo(type), transient(transient),
+	lookupTable(EntityMap<size_t>::allocator_type(resource)),
+	epochIndex(resource), entities(resource), removeQueue(resource)
+{}
+
+// returns the index of the given entity's component, or npos if the entity
+// doesn't have one
+inline size_t PoolBase::indexOf(ID id) const
+{
+	if(transient)
+	{
+		return epochIndex.find(id);
+	}
+	auto it = lookupTable.find(id);
+	if(it == lookupTable.end())
+	{
+		return npos;
+	}
+	return it->second;
+}
+
+// records the index of the given entity's component
+inline void PoolBase::setIndex(ID id, size_t index)
+{
+	if(transient)
+	{
+		epochIndex.set(id, index);
+		return;
+	}
+	lookupTable[id] = index;
+}
+
+// forgets the index of the given entity's component
+inline void PoolBase::eraseIndex(ID id)
+{
+	if(transient)
+	{
+		epochIndex.erase(id);
+		return;
+	}
+	lookupTable.erase(id);
+}
+
+// recreates the index from scratch to match the list of entities
+inline void PoolBase::rebuildIndex()
+{
+	if(transient)
+	{
+		epochIndex.clear();
+	}
+	else
+	{
+		lookupTable.clear();
+		lookupTable.reserve(entities.size());
+	}
+	for(size_t i = 0; i < entities.size(); i++)
+	{
+		setIndex(entities[i], i);
+	}
+}
+
+// updates the index for a new list of entities, given as possibly
+// unaligned IDs, before they replace the current list. entities at the
+// same position in both lists keep their entries, so replacing a pool with
+// a recent state of itself only touches the entries which have changed
+inline void PoolBase::reindex(const char* ids, size_t count)
+{
+	auto idAt = [ids](size_t i)
+	{
+		ID id;
+		std::memcpy(&id, ids + i * sizeof(ID), sizeof(ID));
+		return id;
+	};
+	size_t same = std::min(count, entities.size());
+	// entries are erased first, since entities can move in either direction
+	for(size_t i = 0; i < entities.size(); i++)
+	{
+		if(i >= same || entities[i] != idAt(i))
+		{
+			eraseIndex(entities[i]);
+		}
+	}
+	for(size_t i = 0; i < count; i++)
+	{
+		if(i >= same || entities[i] != idAt(i))
+		{
+			setIndex(idAt(i), i);
+		}
+	}
+}
+
 // queues an entity's component for removal
 inline void PoolBase::queueRemove(ID id)
 {
+	assert(budget == 0 || removeQueue.size() < queueBudget);
 	removeQueue.push_back(id);
 }
 
 // checks if the pool contains a component for a given entity
-inline bool PoolBase::contains(ID id)
+inline bool PoolBase::contains(ID id) const
 {
-	return (lookupTable.find(id) != lookupTable.end());
+	return indexOf(id) != npos;
+}
+
+// starts loading the part of the index that a lookup of an ID will read
+// first, for a lookup soon after. see prefetchLookup for which lookup
+// tables support it
+inline void PoolBase::prefetchIndex(ID id) const
+{
+	if(transient)
+	{
+		epochIndex.prefetch(id);
+		return;
+	}
+	prefetchLookup(lookupTable, id);
+}
+
+
+// moves an entity's component into the disabled partition at the end of
+// the pool. disabled components are skipped by iteration and searches,
+// but can still be accessed directly.
+inline void PoolBase::disable(ID id)
+{
+	size_t index = indexOf(id);
+	if(index >= active)
+	{
+		return;
+	}
+	active--;
+	if(index != active)
+	{
+		swapSlots(index, active);
+	}
+}
+
+// moves an entity's component back into the enabled partition of the
+// pool. does nothing if the pool has no component for the entity
+inline void PoolBase::enable(ID id)
+{
+	size_t index = indexOf(id);
+	if(index < active || index == npos)
+	{
+		return;
+	}
+	if(index != active)
+	{
+		swapSlots(index, active);
+	}
+	active++;
+}
+
+// checks if the entity's component is in the enabled partition of the pool.
+// behavior is undefined if the entity does not have the component.
+inline bool PoolBase::isEnabled(ID id)
+{
+	return indexOf(id) < active;
 }
 
 // returns an iterator to the start of the list of IDs in the pool
@@ -52,23 +274,99 @@ inline auto PoolBase::entityBegin()
 	return entities.begin();
 }
 
-// returns an iterator to the end of the list of IDs in the pool
+// returns an iterator to the end of the list of enabled IDs in the pool
 inline const auto PoolBase::entityEnd() const
 {
-	return entities.end();
+	return entities.begin() + active;
 }
 
 inline auto PoolBase::entityEnd()
 {
-	return entities.end();
+	return entities.begin() + active;
 }
 
-// returns the number of components in the pool
+// returns the number of components in the pool, including disabled ones
 inline auto PoolBase::size() const
 {
 	return entities.size();
 }
 
+// returns the number of enabled components in the pool
+inline auto PoolBase::activeSize() const
+{
+	return active;
+}
+
+// checks if the pool holds a transient component type
+inline bool PoolBase::isTransient() const
+{
+	return transient;
+}
+
+// returns the registry entry for the pool's component type
+inline const TypeInfo* PoolBase::type() const
+{
+	return typeInfo;
+}
+
+// returns the memory resource the pool allocates from
+inline std::pmr::memory_resource* PoolBase::resource() const
+{
+	return entities.resource();
+}
+
+// reorders the pool so that the entities it shares with another pool come
+// first, in the same order as in the other pool. only enabled components
+// are considered.
+inline void PoolBase::sortAs(PoolBase& other)
+{
+	placeInOrder(other.entities.data(), other.active, 0);
+}
+
+// moves the given entities' components to consecutive positions starting at
+// pos, in the given order. entities which aren't enabled in the pool, or
+// whose components are already before pos, are skipped. returns the
+// position after the last component placed.
+inline size_t PoolBase::placeInOrder(const ID* ids, size_t count, size_t pos)
+{
+	for(size_t i = 0; i < count; i++)
+	{
+		size_t index = indexOf(ids[i]);
+		if(index < active && index >= pos)
+		{
+			if(index != pos)
+			{
+				swapSlots(pos, index);
+			}
+			pos++;
+		}
+	}
+	return pos;
+}
+
+// rearranges the start of the pool in place, so that the component at
+// position i is the one which was at position order[i]. the order must be
+// a permutation of the indices 0 to order.size() - 1.
+inline void PoolBase::applyOrder(const std::pmr::vector<size_t>& order)
+{
+	// where[i] is the current position of the component which started at i,
+	// and at[p] is the starting position of the component currently at p
+	std::pmr::vector<size_t> where(order.size(), resource());
+	std::pmr::vector<size_t> at(order.size(), resource());
+	std::iota(where.begin(), where.end(), 0);
+	std::iota(at.begin(), at.end(), 0);
+	for(size_t i = 0; i < order.size(); i++)
+	{
+		size_t from = where[order[i]];
+		if(from != i)
+		{
+			swapSlots(i, from);
+			where[at[i]] = from;
+			at[from] = at[i];
+		}
+	}
+}
+
 template<typename C>
 struct ComponentPair
 {
@@ -91,15 +389,15 @@ public:
 	{
 	public:
 		using iterator_category = std::bidirectional_iterator_tag;
-		using difference_type = typename std::vector<C>::size_type;
+		using difference_type = std::ptrdiff_t;
 		using value_type = ComponentPair<C>;
 		using pointer = ComponentPair<C>*;
 		using reference = ComponentPair<C>&;
 
-		Iterator(std::vector<C>& components,
-			typename std::vector<C>::iterator componentsIt,
-			std::vector<ID>& ids,
-			typename std::vector<ID>::iterator idsIt);
+		Iterator(Storage<C>& components,
+			typename Storage<C>::iterator componentsIt,
+			Storage<ID>& ids,
+			typename Storage<ID>::iterator idsIt);
 		Iterator(const Iterator& other);
 
 		Iterator& operator=(const Iterator& other);
@@ -119,12 +417,15 @@ public:
 		}
 
 	private:
-		std::vector<C>& components;
-		std::vector<ID>& ids;
-		typename std::vector<C>::iterator componentsIt;
-		typename std::vector<ID>::iterator idsIt;
+		Storage<C>& components;
+		Storage<ID>& ids;
+		typename Storage<C>::iterator componentsIt;
+		typename Storage<ID>::iterator idsIt;
 	};
 
+	explicit Pool(std::pmr::memory_resource* resource
+		= std::pmr::get_default_resource());
+
 	template<typename... Args>
 	C* add(ID, Args... args);
 	virtual void remove(ID id) final;
@@ -132,6 +433,24 @@ public:
 	template<typename... Args>
 	C* queueAdd(ID id, Args... args);
 	virtual void processQueues() final;
+	virtual void dispose(std::pmr::memory_resource* resource) final;
+	virtual void swapSlots(size_t a, size_t b) final;
+	virtual void clear() final;
+	void copy(const Pool<C>& other);
+	void reserve(size_t count, size_t queued = 0);
+	virtual void shrinkToFit() final;
+	void setBudget(size_t count, size_t queued);
+
+	virtual bool save(SnapshotWriter& out) const final;
+	virtual bool load(SnapshotReader& in, const PoolHeader& header,
+		bool adopt) final;
+	virtual bool addRecorded(ID id, const char* data, size_t size,
+		bool queued) final;
+	virtual uint64_t checksum() const final;
+	virtual PoolStats stats() const final;
+
+	template<typename Compare>
+	void sort(Compare compare);
 
 	C* get(ID id);
 	C* tryGet(ID id);
@@ -139,6 +458,8 @@ public:
 	const C* get(ID id) const;
 	const C* tryGet(ID id) const;
 	const C* operator[](ID id) const;
+	void getMany(const ID* ids, size_t count, C** out);
+	void getMany(const ID* ids, size_t count, const C** out) const;
 
 	auto begin();
 	auto end();
@@ -146,15 +467,18 @@ public:
 	const auto end() const;
 
 private:
-	std::vector<C> components;
-	std::vector<std::pair<ID, C>> addQueue;
+	void reserveBudget();
+
+	Storage<C> components;
+	Storage<C> addQueue;
+	std::pmr::vector<ID> addQueueIDs;
 };
 
 template<typename C>
-Pool<C>::Iterator::Iterator(std::vector<C>& components,
-	typename std::vector<C>::iterator componentsIt,
-	std::vector<ID>& ids,
-	typename std::vector<ID>::iterator idsIt)
+Pool<C>::Iterator::Iterator(Storage<C>& components,
+	typename Storage<C>::iterator componentsIt,
+	Storage<ID>& ids,
+	typename Storage<ID>::iterator idsIt)
 	: components(components), componentsIt(componentsIt), ids(ids), idsIt(idsIt)
 {}
 
@@ -212,15 +536,37 @@ auto Pool<C>::Iterator::operator--(int)
 	return it;
 }
 
+template<typename C>
+Pool<C>::Pool(std::pmr::memory_resource* resource)
+	: PoolBase(resource, TypeRegistry::get<C>(), Transient<C>::value),
+	components(resource), addQueue(resource),
+	addQueueIDs(resource)
+{}
+
+// destroys the pool and returns its memory to the resource it was
+// allocated from
+template<typename C>
+void Pool<C>::dispose(std::pmr::memory_resource* resource)
+{
+	this->~Pool();
+	resource->deallocate(this, sizeof(Pool<C>), alignof(Pool<C>));
+}
+
 // add component to a given entity
 template<typename C>
 template<typename... Args>
 C* Pool<C>::add(ID id, Args... args)
 {
-	entities.push_back(id);
-	components.push_back(C{std::forward<Args>(args)...});
-	lookupTable.insert(std::pair<ID, size_t>(id, components.size() - 1));
-	return &components.back();
+	assert(budget == 0 || components.size() < budget);
+	entities.emplaceBack(id);
+	components.emplaceBack(std::forward<Args>(args)...);
+	peak = std::max(peak, components.size());
+	setIndex(id, components.size() - 1);
+	if(active != components.size() - 1)
+	{
+		swapSlots(active, components.size() - 1);
+	}
+	return &components[active++];
 }
 
 // queue component for addition to a given entity
@@ -228,20 +574,45 @@ template<typename C>
 template<typename... Args>
 C* Pool<C>::queueAdd(ID id, Args... args)
 {
-	addQueue.emplace_back(
-		std::pair<ID, C>(id, C(std::forward<Args>(args)...)) );
-	return &addQueue.back.second();
+	assert(budget == 0 || addQueueIDs.size() < queueBudget);
+	addQueueIDs.push_back(id);
+	return &addQueue.emplaceBack(std::forward<Args>(args)...);
 }
 
-// applies all queued additions and removals for the pool
+// applies all queued additions and removals for the pool. queued components
+// are relocated into the pool in one block rather than added one at a time.
+// transient pools are emptied first, keeping their capacity, so that their
+// storage acts as a bump allocator which is reset every frame.
 template<typename C>
 void Pool<C>::processQueues()
 {
-	for(auto& pair : addQueue)
+	if constexpr (Transient<C>::value)
 	{
-		add(pair.first, std::move(pair.second));
+		components.clear();
+		entities.clear();
+		epochIndex.clear();
+		removeQueue.clear();
+		active = 0;
 	}
-	addQueue.clear();
+	for(auto id : addQueueIDs)
+	{
+		setIndex(id, entities.size());
+		entities.emplaceBack(id);
+	}
+	components.append(addQueue);
+	assert(budget == 0 || components.size() <= budget);
+	peak = std::max(peak, components.size());
+	// move the new components in front of any disabled ones
+	for(size_t i = components.size() - addQueueIDs.size();
+		i < components.size(); i++)
+	{
+		if(active != i)
+		{
+			swapSlots(active, i);
+		}
+		active++;
+	}
+	addQueueIDs.clear();
 	for(auto& id : removeQueue)
 	{
 		remove(id);
@@ -254,13 +625,393 @@ void Pool<C>::processQueues()
 template<typename C>
 void Pool<C>::remove(ID id)
 {
-	auto indexIter = lookupTable.find(id);
-	lookupTable[entities.back()] = indexIter->second;
-	entities[indexIter->second] = entities.back();
-	components[indexIter->second] = components.back();
-	components.pop_back();
-	entities.pop_back();
-	lookupTable.erase(indexIter);
+	size_t index = indexOf(id);
+	if(index < active)
+	{
+		active--;
+		// keep the partition intact by first moving the component to the
+		// boundary, unless there are no disabled components to worry about
+		if(active != entities.size() - 1 && index != active)
+		{
+			swapSlots(index, active);
+			index = active;
+		}
+	}
+	setIndex(entities.back(), index);
+	eraseIndex(id);
+	entities.removeSwap(index);
+	components.removeSwap(index);
+}
+
+// removes every component from the pool, including queued ones
+template<typename C>
+void Pool<C>::clear()
+{
+	components.clear();
+	entities.clear();
+	addQueue.clear();
+	addQueueIDs.clear();
+	removeQueue.clear();
+	rebuildIndex();
+	active = 0;
+}
+
+// replaces the pool's components with copies of another pool's. queued
+// operations in the other pool are not copied.
+template<typename C>
+void Pool<C>::copy(const Pool<C>& other)
+{
+	clear();
+	components.assign(other.components.data(), other.components.size());
+	entities.assign(other.entities.data(), other.entities.size());
+	if(transient)
+	{
+		rebuildIndex();
+	}
+	else
+	{
+		lookupTable = other.lookupTable;
+	}
+	active = other.active;
+	peak = std::max(peak, other.peak);
+	budget = other.budget;
+	queueBudget = other.queueBudget;
+	reserveBudget();
+}
+
+// makes room for a number of components, and for a number of additions and
+// removals to be queued between calls to processQueues, growing the arrays,
+// queues and lookup table at once rather than as they fill up. transient
+// pools index by ID slot, so their lookups can still grow.
+template<typename C>
+void Pool<C>::reserve(size_t count, size_t queued)
+{
+	components.reserve(count);
+	entities.reserve(count);
+	addQueue.reserve(queued);
+	addQueueIDs.reserve(queued);
+	removeQueue.reserve(queued);
+	if(!transient)
+	{
+		lookupTable.reserve(count);
+	}
+}
+
+// frees the memory the pool's arrays, queues and lookup table have spare,
+// such as after a level is unloaded. a pool with a budget keeps the memory
+// reserved for it, since it would only have to grow back.
+template<typename C>
+void Pool<C>::shrinkToFit()
+{
+	if(budget != 0)
+	{
+		return;
+	}
+	components.shrinkToFit();
+	entities.shrinkToFit();
+	addQueue.shrinkToFit();
+	addQueueIDs.shrink_to_fit();
+	removeQueue.shrink_to_fit();
+	if(!transient)
+	{
+		lookupTable.rehash(0);
+	}
+}
+
+// declares the most components the pool will ever hold at once, and the
+// most additions and removals which will each be queued between calls to
+// processQueues, and reserves memory for them all now. the pool then never
+// grows its arrays or rehashes its lookup table, so no single add or
+// processQueues pays for a reallocation. on most systems large reservations
+// only take up physical memory as they are touched. exceeding a budget is a
+// bug, which debug builds catch with an assertion; otherwise the pool grows
+// as usual. budgets carry over to copies, and are reserved again after
+// loading a snapshot. transient pools index by ID slot, so their lookups
+// can still grow.
+template<typename C>
+void Pool<C>::setBudget(size_t count, size_t queued)
+{
+	budget = count;
+	queueBudget = queued;
+	reserveBudget();
+}
+
+template<typename C>
+void Pool<C>::reserveBudget()
+{
+	if(budget != 0)
+	{
+		reserve(budget, queueBudget);
+	}
+}
+
+// writes the pool's components and IDs to a snapshot. returns false if the
+// component type can't be stored in snapshots. queued additions and
+// removals are not saved.
+template<typename C>
+bool Pool<C>::save(SnapshotWriter& out) const
+{
+	if constexpr (!canSnapshot<C>)
+	{
+		return false;
+	}
+	else
+	{
+		PoolHeader header{typeInfo->key, entities.size(), active, 0,
+			sizeof(C), rawSnapshot<C>};
+		std::vector<char> serialized;
+		if constexpr (rawSnapshot<C>)
+		{
+			header.componentBytes = components.size() * sizeof(C);
+		}
+		else
+		{
+			// each component is prefixed with its size in bytes
+			SnapshotWriter elements(serialized);
+			for(auto& component : components)
+			{
+				size_t start = serialized.size();
+				elements.writeValue(uint32_t(0));
+				Serializer<C>::write(component, elements);
+				uint32_t length = serialized.size() - start - sizeof(uint32_t);
+				std::memcpy(serialized.data() + start, &length, sizeof(uint32_t));
+			}
+			header.componentBytes = serialized.size();
+		}
+
+		out.writeValue(header);
+		out.pad();
+		out.write(entities.data(), entities.size() * sizeof(ID));
+		out.pad();
+		if constexpr (rawSnapshot<C>)
+		{
+			out.write(components.data(), header.componentBytes);
+		}
+		else
+		{
+			out.write(serialized.data(), serialized.size());
+		}
+		out.pad();
+		return true;
+	}
+}
+
+// replaces the contents of the pool with a pool section of a snapshot,
+// positioned just after its header. if adopt is true, raw arrays which are
+// suitably aligned are used in place instead of being copied, and the
+// snapshot memory must outlive the pool's use of it. index entries for
+// entities at the same position as before are kept (see reindex). returns
+// false, leaving the pool unchanged, if the section doesn't fit the header
+// or the data
+template<typename C>
+bool Pool<C>::load(SnapshotReader& in, const PoolHeader& header, bool adopt)
+{
+	if(header.componentSize != sizeof(C) || header.raw != rawSnapshot<C> ||
+		!canSnapshot<C> || header.active > header.count ||
+		header.count > in.remaining() / sizeof(ID))
+	{
+		return false;
+	}
+	if constexpr (rawSnapshot<C>)
+	{
+		if(header.componentBytes != header.count * sizeof(C))
+		{
+			return false;
+		}
+	}
+	SnapshotReader source = in;
+	const char* ids = source.take(header.count * sizeof(ID));
+	source.pad();
+	const char* data = source.take(header.componentBytes);
+	source.pad();
+	if(!source.good())
+	{
+		return false;
+	}
+	if constexpr (!rawSnapshot<C>)
+	{
+		// each component is stored as a length and that many bytes
+		SnapshotReader elements(data, header.componentBytes);
+		for(size_t i = 0; i < header.count; i++)
+		{
+			elements.skip(elements.readValue<uint32_t>());
+		}
+		if(!elements.good())
+		{
+			return false;
+		}
+	}
+	in = source;
+	reindex(ids, header.count);
+	components.clear();
+	entities.clear();
+	addQueue.clear();
+	addQueueIDs.clear();
+	removeQueue.clear();
+
+	bool idsAligned = reinterpret_cast<uintptr_t>(ids) % alignof(ID) == 0;
+	if(adopt && idsAligned)
+	{
+		entities.adopt(reinterpret_cast<ID*>(const_cast<char*>(ids)),
+			header.count);
+	}
+	else
+	{
+		entities.assign(reinterpret_cast<const ID*>(ids), header.count);
+	}
+
+	if constexpr (rawSnapshot<C>)
+	{
+		bool aligned = reinterpret_cast<uintptr_t>(data) % alignof(C) == 0;
+		if(adopt && aligned)
+		{
+			components.adopt(reinterpret_cast<C*>(const_cast<char*>(data)),
+				header.count);
+		}
+		else
+		{
+			components.assign(reinterpret_cast<const C*>(data), header.count);
+		}
+	}
+	else if constexpr (canSnapshot<C>)
+	{
+		SnapshotReader elements(data, header.componentBytes);
+		components.reserve(header.count);
+		for(size_t i = 0; i < header.count; i++)
+		{
+			uint32_t length = elements.readValue<uint32_t>();
+			SnapshotReader element(elements.take(length), length);
+			components.emplaceBack(Serializer<C>::read(element));
+		}
+	}
+
+	active = header.active;
+	peak = std::max(peak, components.size());
+	reserveBudget();
+	return true;
+}
+
+// adds or queues a component stored by CommandLog. returns false if the
+// data doesn't match the component type
+template<typename C>
+bool Pool<C>::addRecorded(ID id, const char* data, size_t size, bool queued)
+{
+	if constexpr (rawSnapshot<C>)
+	{
+		if(size != sizeof(C))
+		{
+			return false;
+		}
+		alignas(C) char bytes[sizeof(C)];
+		std::memcpy(bytes, data, sizeof(C));
+		const C& component = *std::launder(reinterpret_cast<C*>(bytes));
+		queued ? queueAdd(id, component) : add(id, component);
+		return true;
+	}
+	else if constexpr (canSnapshot<C>)
+	{
+		SnapshotReader in(data, size);
+		C component = Serializer<C>::read(in);
+		queued ? queueAdd(id, std::move(component))
+			: add(id, std::move(component));
+		return true;
+	}
+	else
+	{
+		return false;
+	}
+}
+
+// hashes the pool's entity IDs, their order, which are enabled, and the
+// bytes of the components. trivially copyable components are hashed
+// directly, so any padding inside them must be zeroed for the checksum to
+// be deterministic. components with a Serializer are hashed through it, and
+// components which can't be stored in snapshots aren't hashed at all.
+// queued operations are ignored.
+template<typename C>
+uint64_t Pool<C>::checksum() const
+{
+	uint64_t hash = hashBytes(entities.data(), entities.size() * sizeof(ID),
+		typeInfo->key ^ active);
+	if constexpr (rawSnapshot<C>)
+	{
+		hash = hashBytes(components.data(), components.size() * sizeof(C),
+			hash);
+	}
+	else if constexpr (canSnapshot<C>)
+	{
+		std::vector<char> bytes;
+		for(auto& component : components)
+		{
+			bytes.clear();
+			SnapshotWriter out(bytes);
+			Serializer<C>::write(component, out);
+			hash = hashBytes(bytes.data(), bytes.size(), hash);
+		}
+	}
+	return hash;
+}
+
+// reports how much memory the pool uses and how full it is
+template<typename C>
+PoolStats Pool<C>::stats() const
+{
+	PoolStats stats{};
+	stats.name = typeInfo->name;
+	stats.componentSize = sizeof(C);
+	stats.count = components.size();
+	stats.active = active;
+	stats.peak = peak;
+	stats.capacity = components.capacity();
+	stats.componentBytes = components.capacity() * sizeof(C);
+	stats.entityCapacity = entities.capacity();
+	stats.entityBytes = entities.capacity() * sizeof(ID);
+	if(transient)
+	{
+		stats.lookupBuckets = epochIndex.slots();
+		stats.lookupBytes = epochIndex.bytes();
+		stats.loadFactor = stats.lookupBuckets == 0 ? 0.0f
+			: float(components.size()) / stats.lookupBuckets;
+	}
+	else
+	{
+		stats.lookupBuckets = lookupTable.bucket_count();
+		stats.lookupBytes = lookupBytes(lookupTable);
+		stats.loadFactor = lookupTable.load_factor();
+	}
+	stats.queuedAdds = addQueueIDs.size();
+	stats.queuedRemoves = removeQueue.size();
+	stats.queueBytes = addQueue.capacity() * sizeof(C) +
+		(addQueueIDs.capacity() + removeQueue.capacity()) * sizeof(ID);
+	stats.totalBytes = stats.componentBytes + stats.entityBytes +
+		stats.lookupBytes + stats.queueBytes;
+	return stats;
+}
+
+// sorts the enabled components in the pool. compare takes two const C&
+// and returns true if the first should come before the second.
+template<typename C>
+template<typename Compare>
+void Pool<C>::sort(Compare compare)
+{
+	std::pmr::vector<size_t> order(active, resource());
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [&](size_t l, size_t r)
+	{
+		return compare(static_cast<const C&>(components[l]),
+			static_cast<const C&>(components[r]));
+	});
+	applyOrder(order);
+}
+
+// exchanges the positions of two components and their IDs
+template<typename C>
+void Pool<C>::swapSlots(size_t a, size_t b)
+{
+	setIndex(entities[a], b);
+	setIndex(entities[b], a);
+	entities.swapElements(a, b);
+	components.swapElements(a, b);
 }
 
 // gets the component for a given ID. behavior is undefined if the entity
@@ -268,7 +1019,7 @@ void Pool<C>::remove(ID id)
 template<typename C>
 const C* Pool<C>::get(ID id) const
 {
-	return &components[lookupTable.find(id)->second];
+	return &components[indexOf(id)];
 }
 
 template<typename C>
@@ -282,18 +1033,18 @@ C* Pool<C>::get(ID id)
 template<typename C>
 const C* Pool<C>::tryGet(ID id) const
 {
-	auto it = lookupTable.find(id);
-	if(it == lookupTable.end())
+	size_t index = indexOf(id);
+	if(index == npos)
 	{
 		return nullptr;
 	}
-	return &components[it->second].data;
+	return &components[index];
 }
 
 template<typename C>
 C* Pool<C>::tryGet(ID id)
 {
-	return const_cast<C*>(tryGet(id));
+	return const_cast<C*>(const_cast<const Pool<C>&>(*this).tryGet(id));
 }
 
 // alternate syntax for get()
@@ -309,6 +1060,42 @@ C* Pool<C>::operator[](ID id)
 	return get(id);
 }
 
+// gets the components of many entities at once, writing a pointer to each
+// to out, or nullptr if the entity doesn't have the component. the lookups
+// are pipelined: the index is prefetched a few IDs ahead of the one being
+// resolved, and each component as soon as it's found, so the cache misses
+// for different IDs overlap rather than being waited on one by one
+template<typename C>
+void Pool<C>::getMany(const ID* ids, size_t count, const C** out) const
+{
+	for(size_t i = 0; i < count && i < lookahead; i++)
+	{
+		prefetchIndex(ids[i]);
+	}
+	for(size_t i = 0; i < count; i++)
+	{
+		if(i + lookahead < count)
+		{
+			prefetchIndex(ids[i + lookahead]);
+		}
+		size_t index = indexOf(ids[i]);
+		if(index == npos)
+		{
+			out[i] = nullptr;
+			continue;
+		}
+		out[i] = &components[index];
+		prefetch(out[i]);
+	}
+}
+
+template<typename C>
+void Pool<C>::getMany(const ID* ids, size_t count, C** out)
+{
+	const_cast<const Pool<C>&>(*this).getMany(ids, count,
+		const_cast<const C**>(out));
+}
+
 // returns iterator to the start of the pool of components.
 // iterator references objects of type ComponentPair<C>
 template<typename C>
@@ -318,13 +1105,13 @@ auto Pool<C>::begin()
 		entities, entities.begin());
 }
 
-// returns iterator to the end of the pool of components.
+// returns iterator to the end of the enabled components in the pool.
 // iterator references objects of type ComponentPair<C>
 template<typename C>
 auto Pool<C>::end()
 {
-	return Iterator(components, components.end(),
-		entities, entities.end());
+	return Iterator(components, components.begin() + active,
+		entities, entities.begin() + active);
 }
 
 template<typename C>
@@ -337,8 +1124,8 @@ const auto Pool<C>::begin() const
 template<typename C>
 const auto Pool<C>::end() const
 {
-	return Iterator(components, components.end(),
-		entities, entities.end());
+	return Iterator(components, components.begin() + active,
+		entities, entities.begin() + active);
 }
 
 }
@@ -0,0 +1,232 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// the number of events each thread keeps before overwriting the oldest
+#ifndef SCUM_PROFILE_BUFFER_SIZE
+#define SCUM_PROFILE_BUFFER_SIZE 65536
+#endif
+
+// times the rest of the enclosing scope under the given name, which must be
+// a string literal or otherwise outlive the profiler. compiled out unless
+// SCUM_PROFILE is defined. the library's own phases, such as
+// Manager::processQueues, are timed the same way.
+#ifdef SCUM_PROFILE
+#define SCUM_PROFILE_CONCAT_INNER(a, b) a##b
+#define SCUM_PROFILE_CONCAT(a, b) SCUM_PROFILE_CONCAT_INNER(a, b)
+#define SCUM_PROFILE_SCOPE(name) \
+	scum::ProfileScope SCUM_PROFILE_CONCAT(scumProfileScope, __LINE__)(name)
+#else
+#define SCUM_PROFILE_SCOPE(name) ((void)0)
+#endif
+
+namespace scum
+{
+
+// collects timed scopes from every thread and exports them as Chrome
+// trace-event JSON, which can be opened in chrome://tracing or Perfetto.
+// each thread records into its own ring buffer without locking, so the
+// only shared work is registering a thread's buffer the first time it
+// records. exporting while other threads are recording can catch events
+// which are being overwritten, so export between frames where possible.
+class Profiler
+{
+public:
+	static void record(const char* name, int64_t start, int64_t end);
+	static int64_t now();
+
+	static std::string traceJSON();
+	static bool saveTrace(const std::string& path);
+	static void clear();
+
+private:
+	struct Event
+	{
+		const char* name;
+		int64_t start; // nanoseconds since the profiler's epoch
+		int64_t duration;
+	};
+
+	struct Buffer
+	{
+		explicit Buffer(uint32_t thread);
+
+		uint32_t thread;
+		// the number of events ever recorded. only written by the owner
+		std::atomic<uint64_t> head{0};
+		std::unique_ptr<Event[]> events;
+	};
+
+	static Buffer& threadBuffer();
+	static std::vector<std::unique_ptr<Buffer>>& buffers();
+	static std::mutex& buffersMutex();
+	static std::chrono::steady_clock::time_point epoch();
+	static void appendEscaped(std::string& out, const char* text);
+};
+
+// times its own lifetime and records it with the profiler
+class ProfileScope
+{
+public:
+	explicit ProfileScope(const char* name);
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+	~ProfileScope();
+
+private:
+	const char* name;
+	int64_t start;
+};
+
+inline Profiler::Buffer::Buffer(uint32_t thread)
+	: thread(thread), events(new Event[SCUM_PROFILE_BUFFER_SIZE])
+{}
+
+// records an event on the calling thread's buffer. start and end are
+// times returned by now()
+inline void Profiler::record(const char* name, int64_t start, int64_t end)
+{
+	Buffer& buffer = threadBuffer();
+	uint64_t head = buffer.head.load(std::memory_order_relaxed);
+	buffer.events[head % SCUM_PROFILE_BUFFER_SIZE] =
+		Event{name, start, end - start};
+	buffer.head.store(head + 1, std::memory_order_release);
+}
+
+// returns the current time in nanoseconds since the profiler's epoch
+inline int64_t Profiler::now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>
+		(std::chrono::steady_clock::now() - epoch()).count();
+}
+
+// returns every recorded event which hasn't been overwritten, as a Chrome
+// trace-event JSON document
+inline std::string Profiler::traceJSON()
+{
+	std::string json = "{\"traceEvents\":[";
+	bool first = true;
+	char number[96];
+	std::lock_guard<std::mutex> lock(buffersMutex());
+	for(auto& buffer : buffers())
+	{
+		uint64_t head = buffer->head.load(std::memory_order_acquire);
+		uint64_t count = head < SCUM_PROFILE_BUFFER_SIZE ? head
+			: SCUM_PROFILE_BUFFER_SIZE;
+		for(uint64_t i = head - count; i < head; i++)
+		{
+			const Event& event = buffer->events[i % SCUM_PROFILE_BUFFER_SIZE];
+			json += first ? "\n" : ",\n";
+			first = false;
+			json += "{\"name\":\"";
+			appendEscaped(json, event.name);
+			// trace times are in microseconds
+			std::snprintf(number, sizeof(number),
+				"\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+				buffer->thread, event.start / 1000.0, event.duration / 1000.0);
+			json += number;
+		}
+	}
+	json += "\n]}\n";
+	return json;
+}
+
+// writes traceJSON() to a file
+inline bool Profiler::saveTrace(const std::string& path)
+{
+	std::FILE* file = std::fopen(path.c_str(), "wb");
+	if(file == nullptr)
+	{
+		return false;
+	}
+	std::string json = traceJSON();
+	bool ok = std::fwrite(json.data(), 1, json.size(), file) == json.size();
+	return (std::fclose(file) == 0) && ok;
+}
+
+// forgets every recorded event. threads must not be recording at the time
+inline void Profiler::clear()
+{
+	std::lock_guard<std::mutex> lock(buffersMutex());
+	for(auto& buffer : buffers())
+	{
+		buffer->head.store(0, std::memory_order_relaxed);
+	}
+}
+
+// returns the calling thread's buffer, creating it on first use. buffers
+// belong to the profiler rather than the thread, so a thread's events can
+// still be exported after it exits
+inline Profiler::Buffer& Profiler::threadBuffer()
+{
+	thread_local Buffer* buffer = nullptr;
+	if(buffer == nullptr)
+	{
+		std::lock_guard<std::mutex> lock(buffersMutex());
+		auto& list = buffers();
+		list.push_back(std::make_unique<Buffer>(uint32_t(list.size() + 1)));
+		buffer = list.back().get();
+	}
+	return *buffer;
+}
+
+inline std::vector<std::unique_ptr<Profiler::Buffer>>& Profiler::buffers()
+{
+	static std::vector<std::unique_ptr<Buffer>> list;
+	return list;
+}
+
+inline std::mutex& Profiler::buffersMutex()
+{
+	static std::mutex mutex;
+	return mutex;
+}
+
+inline std::chrono::steady_clock::time_point Profiler::epoch()
+{
+	static const auto start = std::chrono::steady_clock::now();
+	return start;
+}
+
+// appends text to a JSON string, escaping quotes, backslashes, and
+// control characters
+inline void Profiler::appendEscaped(std::string& out, const char* text)
+{
+	for(; *text != '\0'; text++)
+	{
+		char c = *text;
+		if(c == '"' || c == '\\')
+		{
+			out += '\\';
+			out += c;
+		}
+		else if(static_cast<unsigned char>(c) < 0x20)
+		{
+			char escaped[8];
+			std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+			out += escaped;
+		}
+		else
+		{
+			out += c;
+		}
+	}
+}
+
+inline ProfileScope::ProfileScope(const char* name)
+	: name(name), start(Profiler::now())
+{}
+
+inline ProfileScope::~ProfileScope()
+{
+	Profiler::record(name, start, Profiler::now());
+}
+
+}
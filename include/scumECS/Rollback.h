@@ -0,0 +1,111 @@
+#pragma once
+
+#include "Types.h"
+#include "Manager.h"
+#include "Snapshot.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace scum
+{
+
+// keeps the states of a manager over its last few frames, so that a
+// misprediction can be fixed by restoring an earlier frame and simulating
+// forward again. states are stored in a ring of snapshot buffers which are
+// reused rather than reallocated. once the buffers and the manager's pools
+// have grown to fit the world, capturing and restoring don't allocate any
+// memory, except for pools which use a Serializer.
+class Rollback
+{
+public:
+	explicit Rollback(size_t slots, size_t bytesPerSlot = 0);
+
+	bool capture(const Manager& manager, uint64_t frame);
+	bool restore(Manager& manager, uint64_t frame) const;
+	bool contains(uint64_t frame) const;
+	void reserve(size_t bytesPerSlot);
+	void clear();
+	size_t slots() const;
+
+private:
+	struct Slot
+	{
+		uint64_t frame = 0;
+		bool used = false;
+		std::vector<char> data;
+	};
+	std::vector<Slot> ring;
+};
+
+// creates a ring of the given number of slots, each with room for a
+// snapshot of the given size
+inline Rollback::Rollback(size_t slots, size_t bytesPerSlot)
+	: ring(slots == 0 ? 1 : slots)
+{
+	reserve(bytesPerSlot);
+}
+
+// saves the manager's state as the given frame, replacing the frame
+// stored in the same slot (frame % slots). returns false if the manager
+// can't be saved (see Manager::save), in which case the slot is left empty.
+inline bool Rollback::capture(const Manager& manager, uint64_t frame)
+{
+	Slot& slot = ring[frame % ring.size()];
+	slot.data.clear();
+	SnapshotWriter out(slot.data);
+	slot.used = manager.save(out);
+	slot.frame = frame;
+	return slot.used;
+}
+
+// replaces the manager's state with a captured frame. the other stored
+// frames are kept, so the same frame can be restored more than once.
+// components are copied back in full, but lookup table entries are only
+// updated for entities which have moved within their pools since the
+// frame, so restoring a recent frame costs little more than a copy.
+// returns false if the frame is no longer stored.
+inline bool Rollback::restore(Manager& manager, uint64_t frame) const
+{
+	if(!contains(frame))
+	{
+		return false;
+	}
+	const Slot& slot = ring[frame % ring.size()];
+	SnapshotReader in(slot.data.data(), slot.data.size());
+	return manager.load(in, false);
+}
+
+// checks if a frame is stored in the ring
+inline bool Rollback::contains(uint64_t frame) const
+{
+	const Slot& slot = ring[frame % ring.size()];
+	return slot.used && slot.frame == frame;
+}
+
+// makes sure every slot can hold a snapshot of the given size without
+// reallocating
+inline void Rollback::reserve(size_t bytesPerSlot)
+{
+	for(auto& slot : ring)
+	{
+		slot.data.reserve(bytesPerSlot);
+	}
+}
+
+// forgets all stored frames, keeping the slots' memory
+inline void Rollback::clear()
+{
+	for(auto& slot : ring)
+	{
+		slot.used = false;
+		slot.data.clear();
+	}
+}
+
+inline size_t Rollback::slots() const
+{
+	return ring.size();
+}
+
+}
@@ -1,7 +1,18 @@
 #pragma once
 
 #include "Types.h"
+#include "Storage.h"
+#include <algorithm>
+#include <utility>
+
+#ifdef SCUM_SEARCH_TELEMETRY
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <typeinfo>
 #include <vector>
+#endif
 
 namespace scum
 {
@@ -11,6 +22,34 @@ class Manager;
 template<typename... Cs>
 class Search;
 
+#ifdef SCUM_SEARCH_TELEMETRY
+// totals for every search over one set of component types, for finding
+// searches which scan many candidates per match. only collected when
+// SCUM_SEARCH_TELEMETRY is defined. each search which has been iterated
+// adds its counts when it is destroyed, so searches on different threads
+// can be counted at once, and copies which are never iterated don't count.
+struct SearchTelemetry
+{
+	explicit SearchTelemetry(std::vector<const char*> components);
+
+	std::vector<const char*> components; // the searched types' names
+	std::atomic<uint64_t> searches{0};
+	// entities taken from the smallest pool and checked against the others
+	std::atomic<uint64_t> candidates{0};
+	std::atomic<uint64_t> matches{0};
+	// contains() calls made on each component's pool, indexed like
+	// components. the smallest pool isn't probed
+	std::unique_ptr<std::atomic<uint64_t>[]> probes;
+
+	static std::vector<SearchTelemetry*> all();
+	static void reset();
+
+private:
+	static std::vector<SearchTelemetry*>& list();
+	static std::mutex& listMutex();
+};
+#endif
+
 // an object which allows for quick lookup of all the entities which have
 // a certain set of components
 template<typename... Cs>
@@ -23,11 +62,11 @@ public:
 		using iterator_category = std::forward_iterator_tag;
 		using difference_type = std::ptrdiff_t;
 		using value_type = ID;
-		using pointer = ID*;
-		using reference = ID&;
+		using pointer = const ID*;
+		using reference = const ID&;
 
-		Iterator(Search* search, std::vector<ID>::iterator cur,
-			std::vector<ID>::iterator end);
+		Iterator(Search* search, Storage<ID>::const_iterator cur,
+			Storage<ID>::const_iterator end);
 		Iterator(const Iterator& other);
 		Iterator& operator=(const Iterator& other);
 		reference operator*() const;
@@ -44,25 +83,51 @@ public:
 		}
 
 	private:
+		// how many candidates ahead withPrefetch loads index entries. each
+		// step does less work than a get, so this is further than getMany
+		static constexpr size_t distance = 2 * PoolBase::lookahead;
+
 		bool valid() const;
+		void prefetchAhead() const;
 
 		Search<Cs...>* search;
-		std::vector<ID>::iterator cur;
-		std::vector<ID>::iterator end;
+		Storage<ID>::const_iterator cur;
+		Storage<ID>::const_iterator end;
 	};
 
-	Search(Manager& mgr);	
+	Search(const Manager& mgr);
+	Search& withPrefetch() &;
+	Search withPrefetch() &&;
 	auto begin();
 	auto end();
 
+#ifdef SCUM_SEARCH_TELEMETRY
+	~Search();
+	static SearchTelemetry& telemetry();
+#endif
+
 private:
-	Manager& mgr;
-	PoolBase* smallest;
-	std::vector<PoolBase*> others;
+	// the pools other than the smallest, which candidates are checked
+	// against. kept inline so that creating a search never allocates
+	static constexpr size_t otherCount = sizeof...(Cs) - 1;
+	const Manager& mgr;
+	const PoolBase* smallest;
+	const PoolBase* others[otherCount == 0 ? 1 : otherCount];
+	size_t added = 0; // pools added to others so far
+	bool prefetching = false; // see withPrefetch
+
+#ifdef SCUM_SEARCH_TELEMETRY
+	// counts for this search, added to telemetry() when it is destroyed
+	size_t otherComponents[otherCount == 0 ? 1 : otherCount]; // index in Cs
+	bool begun = false; // whether begin() has been called
+	uint64_t candidates = 0;
+	uint64_t matches = 0;
+	uint64_t probes[sizeof...(Cs)] = {};
+#endif
 
 	void getSmallest();
 	template<typename C, typename... OtherC>
-	PoolBase* getSmallestHelper();
+	const PoolBase* getSmallestHelper();
 };
 
 }
@@ -75,23 +140,65 @@ namespace scum
 template<typename... Cs>
 bool Search<Cs...>::Iterator::valid() const
 {
-	bool valid = true;
-	for(auto* pool : search->others)
+	if(search->prefetching)
+	{
+		prefetchAhead();
+	}
+#ifdef SCUM_SEARCH_TELEMETRY
+	search->candidates++;
+#endif
+	for(size_t i = 0; i < otherCount; i++)
+	{
+#ifdef SCUM_SEARCH_TELEMETRY
+		search->probes[search->otherComponents[i]]++;
+#endif
+		if(!search->others[i]->contains(*cur))
+		{
+			return false;
+		}
+	}
+#ifdef SCUM_SEARCH_TELEMETRY
+	search->matches++;
+#endif
+	return true;
+}
+
+// starts loading the other pools' index entries for the candidate some way
+// ahead of the current one, so that they've arrived by the time valid()
+// probes them
+template<typename... Cs>
+void Search<Cs...>::Iterator::prefetchAhead() const
+{
+	if(size_t(end - cur) > distance)
 	{
-		valid = valid && pool->contains(*cur);
+		for(size_t i = 0; i < otherCount; i++)
+		{
+			search->others[i]->prefetchIndex(cur[distance]);
+		}
 	}
-	return valid;
 }
 
 template<typename... Cs>
 Search<Cs...>::Iterator::Iterator
-	(Search<Cs...>* search, std::vector<ID>::iterator cur,
-	 std::vector<ID>::iterator end)
+	(Search<Cs...>* search, Storage<ID>::const_iterator cur,
+	 Storage<ID>::const_iterator end)
 	: search(search), cur(cur), end(end)
 {
-	while(cur != search->smallest->entityEnd() && !valid())
+	// prefetch the first candidates, which prefetchAhead never reaches
+	if(search->prefetching)
 	{
-		cur++;
+		size_t count = std::min(size_t(end - cur), distance);
+		for(size_t i = 0; i < otherCount; i++)
+		{
+			for(size_t j = 0; j < count; j++)
+			{
+				search->others[i]->prefetchIndex(cur[j]);
+			}
+		}
+	}
+	while(this->cur != end && !valid())
+	{
+		this->cur++;
 	}
 }
 
@@ -111,7 +218,7 @@ typename Search<Cs...>::Iterator& Search<Cs...>::Iterator::operator=
 }
 
 template<typename... Cs>
-ID& Search<Cs...>::Iterator::operator*() const
+const ID& Search<Cs...>::Iterator::operator*() const
 {
 	return *cur;
 }
@@ -139,13 +246,27 @@ auto Search<Cs...>::Iterator::operator++(int)
 template<typename... Cs>
 void Search<Cs...>::getSmallest()
 {
-	others.clear();
+	added = 0;
 	smallest = getSmallestHelper<Cs...>();
+#ifdef SCUM_SEARCH_TELEMETRY
+	const size_t types[] = {typeid(Cs).hash_code()...};
+	for(size_t j = 0; j < otherCount; j++)
+	{
+		for(size_t i = 0; i < sizeof...(Cs); i++)
+		{
+			if(types[i] == others[j]->type()->hash)
+			{
+				otherComponents[j] = i;
+				break;
+			}
+		}
+	}
+#endif
 }
 
 template<typename... Cs>
 template<typename C, typename... OtherC>
-PoolBase* Search<Cs...>::getSmallestHelper()
+const PoolBase* Search<Cs...>::getSmallestHelper()
 {
 	if constexpr (sizeof...(OtherC) == 0)
 	{
@@ -154,29 +275,56 @@ PoolBase* Search<Cs...>::getSmallestHelper()
 	else
 	{
 		auto* small = getSmallestHelper<OtherC...>();
-		PoolBase* pool = &(mgr.getPool<C>());
-		if(pool->size() < small->size())
+		const PoolBase* pool = &(mgr.getPool<C>());
+		if(pool->activeSize() < small->activeSize())
 		{
-			others.push_back(small);
+			others[added++] = small;
 			return pool;
 		}
 
-		others.push_back(pool);
+		others[added++] = pool;
 		return small;
 	}
 }
 
 template<typename... Cs>
-Search<Cs...>::Search(Manager& mgr) : mgr(mgr)
+Search<Cs...>::Search(const Manager& mgr) : mgr(mgr)
 {
 	getSmallest();
 }
 
+// makes the search prefetch while iterating and returns it, for
+// searches over large pools whose lookups mostly miss the cache, such as
+// pools which have been shuffled by churn. each step starts loading the
+// other pools' index entries for a candidate a little way ahead, so that
+// their cache misses overlap. robin_map and std::unordered_map can't be
+// prefetched this way (see prefetchLookup), and the processor often
+// overlaps the misses well enough by itself, so measure before using it.
+// e.g. for(ID id : manager.search<Position, Velocity>().withPrefetch())
+template<typename... Cs>
+Search<Cs...>& Search<Cs...>::withPrefetch() &
+{
+	prefetching = otherCount != 0;
+	return *this;
+}
+
+// a temporary search is returned by value, so that a range-based for loop
+// over it doesn't outlive it
+template<typename... Cs>
+Search<Cs...> Search<Cs...>::withPrefetch() &&
+{
+	prefetching = otherCount != 0;
+	return std::move(*this);
+}
+
 // returns an iterator to the first entity which meets the requirements.
 // the iterator references objects of type ID.
 template<typename... Cs>
 auto Search<Cs...>::begin()
 {
+#ifdef SCUM_SEARCH_TELEMETRY
+	begun = true;
+#endif
 	return Search<Cs...>::Iterator
 		(this, smallest->entityBegin(), smallest->entityEnd());
 }
@@ -190,4 +338,74 @@ auto Search<Cs...>::end()
 		(this, smallest->entityEnd(), smallest->entityEnd());
 }
 
+#ifdef SCUM_SEARCH_TELEMETRY
+inline SearchTelemetry::SearchTelemetry(std::vector<const char*> components)
+	: components(std::move(components)),
+	probes(new std::atomic<uint64_t>[this->components.size()]())
+{
+	std::lock_guard<std::mutex> lock(listMutex());
+	list().push_back(this);
+}
+
+// returns the telemetry of every set of components searched so far
+inline std::vector<SearchTelemetry*> SearchTelemetry::all()
+{
+	std::lock_guard<std::mutex> lock(listMutex());
+	return list();
+}
+
+// sets every counter back to zero
+inline void SearchTelemetry::reset()
+{
+	for(auto* telemetry : all())
+	{
+		telemetry->searches = 0;
+		telemetry->candidates = 0;
+		telemetry->matches = 0;
+		for(size_t i = 0; i < telemetry->components.size(); i++)
+		{
+			telemetry->probes[i] = 0;
+		}
+	}
+}
+
+inline std::vector<SearchTelemetry*>& SearchTelemetry::list()
+{
+	static std::vector<SearchTelemetry*> telemetry;
+	return telemetry;
+}
+
+inline std::mutex& SearchTelemetry::listMutex()
+{
+	static std::mutex mutex;
+	return mutex;
+}
+
+template<typename... Cs>
+Search<Cs...>::~Search()
+{
+	if(!begun)
+	{
+		return;
+	}
+	auto& totals = telemetry();
+	auto order = std::memory_order_relaxed;
+	totals.searches.fetch_add(1, order);
+	totals.candidates.fetch_add(candidates, order);
+	totals.matches.fetch_add(matches, order);
+	for(size_t i = 0; i < sizeof...(Cs); i++)
+	{
+		totals.probes[i].fetch_add(probes[i], order);
+	}
+}
+
+// returns the totals for searches over this set of components
+template<typename... Cs>
+SearchTelemetry& Search<Cs...>::telemetry()
+{
+	static SearchTelemetry totals({typeid(Cs).name()...});
+	return totals;
+}
+#endif
+
 }
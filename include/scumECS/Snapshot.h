@@ -0,0 +1,492 @@
+#pragma once
+
+#include "Types.h"
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#define SCUM_HAS_MMAP 1
+#define SCUM_HAS_FORK 1
+#endif
+
+namespace scum
+{
+
+// snapshots are laid out as a SnapshotHeader, the free and disabled ID
+// lists, then one section per pool. each pool section is a PoolHeader,
+// the pool's entity IDs, then its components. every part starts on a
+// SnapshotAlignment boundary, so arrays can be used in place once the file
+// is mapped into memory. raw arrays are stored in the machine's own
+// byte order and layout, so snapshots are not portable between platforms.
+const uint32_t SnapshotMagic = 0x4d554353; // "SCUM"
+const uint32_t SnapshotVersion = 2;
+const size_t SnapshotAlignment = 64;
+
+struct SnapshotHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t poolCount;
+	uint64_t freeIDCount;
+	uint64_t disabledIDCount;
+	ID nextID;
+	uint32_t reserved;
+};
+
+// components in raw pools are stored as a plain array. components in other
+// pools are each stored as a uint32_t byte count followed by whatever their
+// Serializer wrote
+struct PoolHeader
+{
+	uint64_t type; // the component type's key (see TypeName)
+	uint64_t count;
+	uint64_t active;
+	uint64_t componentBytes;
+	uint32_t componentSize;
+	uint32_t raw;
+};
+
+// writes snapshot data, either to a memory buffer or directly to a file
+class SnapshotWriter
+{
+public:
+	explicit SnapshotWriter(std::vector<char>& buffer);
+	explicit SnapshotWriter(std::FILE* file);
+
+	void write(const void* data, size_t size);
+	template<typename T>
+	void writeValue(const T& value);
+	void pad();
+	size_t offset() const;
+	bool good() const;
+
+private:
+	std::vector<char>* buffer = nullptr;
+	std::FILE* file = nullptr;
+	size_t written = 0;
+	bool ok = true;
+};
+
+// reads snapshot data from a block of memory
+class SnapshotReader
+{
+public:
+	SnapshotReader(const char* data, size_t size);
+
+	bool read(void* data, size_t size);
+	template<typename T>
+	T readValue();
+	const char* take(size_t size);
+	bool skip(size_t size);
+	bool pad();
+	size_t offset() const;
+	size_t remaining() const;
+	bool good() const;
+
+private:
+	const char* data;
+	size_t size;
+	size_t pos = 0;
+	bool ok = true;
+};
+
+// converts components which aren't trivially copyable to and from snapshot
+// data. specialize it with functions of the form
+//   static void write(const C& component, scum::SnapshotWriter& out);
+//   static C read(scum::SnapshotReader& in);
+// trivially copyable components are stored as raw bytes unless a
+// specialization exists, and pools of other types can't be saved
+template<typename C>
+struct Serializer
+{};
+
+template<typename C, typename = void>
+struct HasSerializer : std::false_type
+{};
+
+template<typename C>
+struct HasSerializer<C, std::void_t<decltype(Serializer<C>::write(
+	std::declval<const C&>(), std::declval<SnapshotWriter&>()))>>
+	: std::true_type
+{};
+
+// whether a pool of C is stored as a raw array in snapshots
+template<typename C>
+constexpr bool rawSnapshot =
+	std::is_trivially_copyable_v<C> && !HasSerializer<C>::value;
+
+// whether a pool of C can be stored in snapshots at all
+template<typename C>
+constexpr bool canSnapshot =
+	std::is_trivially_copyable_v<C> || HasSerializer<C>::value;
+
+// a read-only view of a whole file. uses a private, copy-on-write mapping
+// where the OS supports it, so that pools can adopt arrays in the file
+// without copying them, and falls back to reading the file into memory.
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile();
+
+	bool open(const std::string& path);
+	void close();
+	char* data() const;
+	size_t size() const;
+
+private:
+	char* address = nullptr;
+	size_t length = 0;
+	bool mapped = false;
+};
+
+// a snapshot being written in the background by Manager::saveInBackground.
+// waits for the snapshot to finish when destroyed.
+class BackgroundSave
+{
+public:
+	BackgroundSave() = default;
+	BackgroundSave(BackgroundSave&& other) noexcept;
+	BackgroundSave& operator=(BackgroundSave&& other) noexcept;
+	BackgroundSave(const BackgroundSave&) = delete;
+	BackgroundSave& operator=(const BackgroundSave&) = delete;
+	~BackgroundSave();
+
+	bool done();
+	bool wait();
+
+private:
+	friend class Manager;
+
+	long process = -1; // the ID of the process writing the snapshot
+	bool finished = true;
+	bool ok = false;
+	std::string tempPath; // removed if the snapshot fails
+};
+
+inline SnapshotWriter::SnapshotWriter(std::vector<char>& buffer)
+	: buffer(&buffer)
+{}
+
+inline SnapshotWriter::SnapshotWriter(std::FILE* file) : file(file)
+{}
+
+// appends bytes to the snapshot
+inline void SnapshotWriter::write(const void* data, size_t size)
+{
+	if(size == 0)
+	{
+		return;
+	}
+	if(file != nullptr)
+	{
+		ok = ok && std::fwrite(data, 1, size, file) == size;
+	}
+	else
+	{
+		const char* bytes = static_cast<const char*>(data);
+		buffer->insert(buffer->end(), bytes, bytes + size);
+	}
+	written += size;
+}
+
+template<typename T>
+void SnapshotWriter::writeValue(const T& value)
+{
+	static_assert(std::is_trivially_copyable_v<T>);
+	write(&value, sizeof(T));
+}
+
+// writes zeroes up to the next SnapshotAlignment boundary
+inline void SnapshotWriter::pad()
+{
+	static const char zeroes[SnapshotAlignment] = {};
+	size_t misalignment = written % SnapshotAlignment;
+	if(misalignment != 0)
+	{
+		write(zeroes, SnapshotAlignment - misalignment);
+	}
+}
+
+// returns the number of bytes written so far
+inline size_t SnapshotWriter::offset() const
+{
+	return written;
+}
+
+// returns false if writing to the file has failed
+inline bool SnapshotWriter::good() const
+{
+	return ok;
+}
+
+inline SnapshotReader::SnapshotReader(const char* data, size_t size)
+	: data(data), size(size)
+{}
+
+// copies bytes out of the snapshot
+inline bool SnapshotReader::read(void* out, size_t count)
+{
+	const char* bytes = take(count);
+	if(bytes != nullptr && count != 0)
+	{
+		std::memcpy(out, bytes, count);
+	}
+	return bytes != nullptr;
+}
+
+// reads a value, returning a value-initialized one if the data has run out
+template<typename T>
+T SnapshotReader::readValue()
+{
+	static_assert(std::is_trivially_copyable_v<T>);
+	T value{};
+	read(&value, sizeof(T));
+	return value;
+}
+
+// returns a pointer to the next count bytes and moves past them, or
+// returns nullptr if there aren't enough bytes left
+inline const char* SnapshotReader::take(size_t count)
+{
+	if(!ok || count > size - pos)
+	{
+		ok = false;
+		return nullptr;
+	}
+	const char* bytes = data + pos;
+	pos += count;
+	return bytes;
+}
+
+inline bool SnapshotReader::skip(size_t count)
+{
+	return take(count) != nullptr;
+}
+
+// moves to the next SnapshotAlignment boundary
+inline bool SnapshotReader::pad()
+{
+	size_t misalignment = pos % SnapshotAlignment;
+	if(misalignment != 0)
+	{
+		return skip(SnapshotAlignment - misalignment);
+	}
+	return ok;
+}
+
+inline size_t SnapshotReader::offset() const
+{
+	return pos;
+}
+
+inline size_t SnapshotReader::remaining() const
+{
+	return size - pos;
+}
+
+// returns false if a read has run past the end of the data
+inline bool SnapshotReader::good() const
+{
+	return ok;
+}
+
+inline MappedFile::MappedFile(MappedFile&& other) noexcept
+	: address(other.address), length(other.length), mapped(other.mapped)
+{
+	other.address = nullptr;
+	other.length = 0;
+}
+
+inline MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if(this != &other)
+	{
+		close();
+		std::swap(address, other.address);
+		std::swap(length, other.length);
+		std::swap(mapped, other.mapped);
+	}
+	return *this;
+}
+
+inline MappedFile::~MappedFile()
+{
+	close();
+}
+
+// maps or reads the whole file. returns false if it can't be opened
+inline bool MappedFile::open(const std::string& path)
+{
+	close();
+#ifdef SCUM_HAS_MMAP
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if(fd < 0)
+	{
+		return false;
+	}
+	struct stat info;
+	if(fstat(fd, &info) != 0 || info.st_size == 0)
+	{
+		::close(fd);
+		return false;
+	}
+	void* region = mmap(nullptr, info.st_size, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if(region == MAP_FAILED)
+	{
+		return false;
+	}
+	address = static_cast<char*>(region);
+	length = info.st_size;
+	mapped = true;
+	return true;
+#else
+	std::FILE* file = std::fopen(path.c_str(), "rb");
+	if(file == nullptr)
+	{
+		return false;
+	}
+	std::fseek(file, 0, SEEK_END);
+	long fileSize = std::ftell(file);
+	std::fseek(file, 0, SEEK_SET);
+	if(fileSize <= 0)
+	{
+		std::fclose(file);
+		return false;
+	}
+	address = static_cast<char*>(::operator new(fileSize,
+		std::align_val_t(SnapshotAlignment)));
+	length = fileSize;
+	mapped = false;
+	bool ok = std::fread(address, 1, length, file) == length;
+	std::fclose(file);
+	if(!ok)
+	{
+		close();
+	}
+	return ok;
+#endif
+}
+
+inline void MappedFile::close()
+{
+	if(address == nullptr)
+	{
+		return;
+	}
+#ifdef SCUM_HAS_MMAP
+	if(mapped)
+	{
+		munmap(address, length);
+	}
+	else
+#endif
+	{
+		::operator delete(address, std::align_val_t(SnapshotAlignment));
+	}
+	address = nullptr;
+	length = 0;
+}
+
+inline char* MappedFile::data() const
+{
+	return address;
+}
+
+inline size_t MappedFile::size() const
+{
+	return length;
+}
+
+inline BackgroundSave::BackgroundSave(BackgroundSave&& other) noexcept
+	: process(other.process), finished(other.finished), ok(other.ok),
+	tempPath(std::move(other.tempPath))
+{
+	other.finished = true;
+}
+
+inline BackgroundSave& BackgroundSave::operator=(BackgroundSave&& other)
+	noexcept
+{
+	if(this != &other)
+	{
+		wait();
+		process = other.process;
+		finished = other.finished;
+		ok = other.ok;
+		tempPath = std::move(other.tempPath);
+		other.finished = true;
+	}
+	return *this;
+}
+
+inline BackgroundSave::~BackgroundSave()
+{
+	wait();
+}
+
+// checks if the snapshot has finished, without blocking
+inline bool BackgroundSave::done()
+{
+#ifdef SCUM_HAS_FORK
+	if(!finished)
+	{
+		int status = 0;
+		if(waitpid(static_cast<pid_t>(process), &status, WNOHANG) != 0)
+		{
+			finished = true;
+			ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+			if(!ok)
+			{
+				std::remove(tempPath.c_str());
+			}
+		}
+	}
+#endif
+	return finished;
+}
+
+// blocks until the snapshot has finished. returns true if it was written
+inline bool BackgroundSave::wait()
+{
+#ifdef SCUM_HAS_FORK
+	if(!finished)
+	{
+		int status = 0;
+		pid_t result;
+		do
+		{
+			result = waitpid(static_cast<pid_t>(process), &status, 0);
+		}
+		while(result < 0 && errno == EINTR);
+		finished = true;
+		ok = result > 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+		if(!ok)
+		{
+			std::remove(tempPath.c_str());
+		}
+	}
+#endif
+	return ok;
+}
+
+}
@@ -0,0 +1,197 @@
+#pragma once
+
+#include "Types.h"
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+namespace scum
+{
+
+// maps IDs to values with a flat array indexed by ID slot, as in a sparse
+// set. lookups are a single indexed load with no hashing or probing, but
+// memory grows with the highest slot stored rather than the number of
+// entries, and clearing touches every slot. IDs which share a slot replace
+// each other, so it only works when, as with IDs from one manager, no two
+// IDs in the map share a slot. provides the subset of the robin_map
+// interface that pools use (see EntityMap).
+template<typename V>
+class SparseMap
+{
+public:
+	struct Entry
+	{
+		ID first; // Null if the slot is empty
+		V second;
+	};
+
+	using value_type = Entry;
+	using allocator_type = std::pmr::polymorphic_allocator<Entry>;
+	using iterator = Entry*;
+	using const_iterator = const Entry*;
+
+	explicit SparseMap(const allocator_type& allocator = allocator_type());
+
+	iterator find(ID id);
+	const_iterator find(ID id) const;
+	void prefetch(ID id) const;
+	iterator end();
+	const_iterator end() const;
+	V& operator[](ID id);
+	size_t erase(ID id);
+	void clear();
+	void reserve(size_t count);
+	void rehash(size_t count);
+
+	size_t size() const;
+	size_t bucket_count() const;
+	float load_factor() const;
+	size_t bytes() const;
+
+private:
+	std::pmr::vector<Entry> entries;
+	size_t count = 0;
+};
+
+template<typename V>
+SparseMap<V>::SparseMap(const allocator_type& allocator)
+	: entries(allocator)
+{}
+
+// returns the entry for an ID, or end() if there isn't one
+template<typename V>
+typename SparseMap<V>::iterator SparseMap<V>::find(ID id)
+{
+	ID slot = slotOf(id);
+	if(slot < entries.size() && entries[slot].first == id && id != Null)
+	{
+		return &entries[slot];
+	}
+	return end();
+}
+
+template<typename V>
+typename SparseMap<V>::const_iterator SparseMap<V>::find(ID id) const
+{
+	ID slot = slotOf(id);
+	if(slot < entries.size() && entries[slot].first == id && id != Null)
+	{
+		return &entries[slot];
+	}
+	return end();
+}
+
+// starts loading the entry an ID would be in, for a find soon after
+template<typename V>
+void SparseMap<V>::prefetch(ID id) const
+{
+	ID slot = slotOf(id);
+	if(slot < entries.size())
+	{
+		scum::prefetch(&entries[slot]);
+	}
+}
+
+template<typename V>
+typename SparseMap<V>::iterator SparseMap<V>::end()
+{
+	return nullptr;
+}
+
+template<typename V>
+typename SparseMap<V>::const_iterator SparseMap<V>::end() const
+{
+	return nullptr;
+}
+
+// returns the value for an ID, adding a value-initialized one if needed.
+// replaces the entry of any other ID in the same slot
+template<typename V>
+V& SparseMap<V>::operator[](ID id)
+{
+	ID slot = slotOf(id);
+	if(slot >= entries.size())
+	{
+		entries.resize(slot + 1, Entry{Null, V()});
+	}
+	Entry& entry = entries[slot];
+	if(entry.first != id)
+	{
+		count += entry.first == Null;
+		entry = Entry{id, V()};
+	}
+	return entry.second;
+}
+
+template<typename V>
+size_t SparseMap<V>::erase(ID id)
+{
+	auto it = find(id);
+	if(it == end())
+	{
+		return 0;
+	}
+	it->first = Null;
+	count--;
+	return 1;
+}
+
+// empties every slot, keeping the memory
+template<typename V>
+void SparseMap<V>::clear()
+{
+	for(auto& entry : entries)
+	{
+		entry.first = Null;
+	}
+	count = 0;
+}
+
+// slots aren't known ahead of time, so this assumes IDs are densely packed
+template<typename V>
+void SparseMap<V>::reserve(size_t count)
+{
+	entries.reserve(count);
+}
+
+// trims the array to the highest slot in use, or the given number of slots
+// if that's more, and frees the spare memory. rehash(0) shrinks it to fit
+template<typename V>
+void SparseMap<V>::rehash(size_t count)
+{
+	size_t used = entries.size();
+	while(used > count && entries[used - 1].first == Null)
+	{
+		used--;
+	}
+	entries.resize(used, Entry{Null, V()});
+	entries.shrink_to_fit();
+}
+
+template<typename V>
+size_t SparseMap<V>::size() const
+{
+	return count;
+}
+
+// returns the number of slots the map has room for
+template<typename V>
+size_t SparseMap<V>::bucket_count() const
+{
+	return entries.capacity();
+}
+
+template<typename V>
+float SparseMap<V>::load_factor() const
+{
+	return entries.empty() ? 0.0f : float(count) / entries.capacity();
+}
+
+// returns the memory allocated by the map
+template<typename V>
+size_t SparseMap<V>::bytes() const
+{
+	return entries.capacity() * sizeof(Entry);
+}
+
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Types.h"
+#include <cstddef>
+#include <vector>
+
+namespace scum
+{
+
+// memory use and occupancy of a pool, as returned by Pool::stats. byte
+// counts are for allocated capacity, not just the elements in use
+struct PoolStats
+{
+	const char* name; // the component type's name, as given by typeid
+	size_t componentSize;
+	size_t count;
+	size_t active; // enabled components
+	size_t peak; // the most components the pool has held at once
+	size_t capacity;
+	size_t componentBytes;
+	size_t entityCapacity;
+	size_t entityBytes;
+	size_t lookupBuckets; // hash table buckets, or ID slots if transient
+	size_t lookupBytes;
+	float loadFactor;
+	size_t queuedAdds;
+	size_t queuedRemoves;
+	size_t queueBytes;
+	size_t totalBytes;
+};
+
+// memory use and occupancy of a manager and all of its pools, as returned
+// by Manager::stats
+struct ManagerStats
+{
+	std::vector<PoolStats> pools;
+	size_t freeIDs;
+	size_t freeIDCapacity;
+	// the most IDs which have been in use at once, counting IDs which have
+	// been used up and retired
+	size_t peakIDs;
+	size_t disabledIDSlots;
+	size_t queuedDestroys;
+	size_t queuedDisables;
+	size_t managerBytes; // memory used by the manager outside of its pools
+	size_t totalBytes;
+};
+
+}
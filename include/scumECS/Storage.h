@@ -0,0 +1,445 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace scum
+{
+
+// marks types which can be moved to a new address with a plain memcpy,
+// leaving nothing behind at the old address that needs destroying.
+// defaults to trivially copyable types. it can be specialized for types which
+// never point into themselves, for example:
+// template<> struct scum::TriviallyRelocatable<MyComponent> : std::true_type {};
+// note that std::string and most small-buffer containers are NOT relocatable.
+template<typename T>
+struct TriviallyRelocatable : std::is_trivially_copyable<T>
+{};
+
+// a minimal contiguous array used to store pool data. unlike std::vector,
+// it moves trivially relocatable elements with memcpy when growing,
+// removing, or appending, and falls back to moving them one by one otherwise.
+// memory is obtained from a std::pmr::memory_resource
+template<typename T>
+class Storage
+{
+public:
+	using iterator = T*;
+	using const_iterator = const T*;
+
+	explicit Storage(std::pmr::memory_resource* resource
+		= std::pmr::get_default_resource());
+	Storage(const Storage& other);
+	Storage(const Storage& other, std::pmr::memory_resource* resource);
+	Storage(Storage&& other) noexcept;
+	Storage& operator=(Storage other) noexcept;
+	~Storage();
+
+	template<typename... Args>
+	T& emplaceBack(Args&&... args);
+	void popBack();
+	void removeSwap(std::size_t index);
+	void swapElements(std::size_t a, std::size_t b);
+	void append(Storage& other);
+	void assign(const T* source, std::size_t n);
+	void adopt(T* external, std::size_t n);
+	void reserve(std::size_t newCap);
+	void shrinkToFit();
+	void clear();
+
+	T& operator[](std::size_t index);
+	const T& operator[](std::size_t index) const;
+	T& back();
+	const T& back() const;
+	T* data();
+	const T* data() const;
+	std::size_t size() const;
+	std::size_t capacity() const;
+	bool empty() const;
+	std::pmr::memory_resource* resource() const;
+
+	iterator begin();
+	iterator end();
+	const_iterator begin() const;
+	const_iterator end() const;
+
+private:
+	static constexpr bool relocatable = TriviallyRelocatable<T>::value;
+
+	static void relocate(T* dst, T* src, std::size_t n);
+	void grow(std::size_t minCapacity);
+
+	std::pmr::memory_resource* memory;
+	T* elements = nullptr;
+	std::size_t count = 0;
+	std::size_t cap = 0;
+	bool owned = true; // false if elements points to adopted memory
+};
+
+// moves n elements from src to uninitialized memory at dst, ending the
+// lifetime of the source elements
+template<typename T>
+void Storage<T>::relocate(T* dst, T* src, std::size_t n)
+{
+	if(n == 0)
+	{
+		return;
+	}
+	if constexpr (relocatable)
+	{
+		std::memcpy(static_cast<void*>(dst), static_cast<const void*>(src),
+			n * sizeof(T));
+	}
+	else
+	{
+		for(std::size_t i = 0; i < n; i++)
+		{
+			new(dst + i) T(std::move(src[i]));
+			src[i].~T();
+		}
+	}
+}
+
+template<typename T>
+void Storage<T>::grow(std::size_t minCapacity)
+{
+	std::size_t newCap = cap * 2;
+	if(newCap < minCapacity)
+	{
+		newCap = minCapacity;
+	}
+	reserve(newCap);
+}
+
+template<typename T>
+Storage<T>::Storage(std::pmr::memory_resource* resource) : memory(resource)
+{}
+
+template<typename T>
+Storage<T>::Storage(const Storage& other) : Storage(other, other.resource())
+{}
+
+template<typename T>
+Storage<T>::Storage(const Storage& other, std::pmr::memory_resource* resource)
+	: memory(resource)
+{
+	reserve(other.count);
+	if constexpr (std::is_trivially_copyable_v<T>)
+	{
+		if(other.count != 0)
+		{
+			std::memcpy(static_cast<void*>(elements),
+				static_cast<const void*>(other.elements), other.count * sizeof(T));
+		}
+	}
+	else
+	{
+		std::uninitialized_copy(other.begin(), other.end(), elements);
+	}
+	count = other.count;
+}
+
+template<typename T>
+Storage<T>::Storage(Storage&& other) noexcept
+	: memory(other.memory), elements(other.elements),
+	count(other.count), cap(other.cap), owned(other.owned)
+{
+	other.elements = nullptr;
+	other.count = 0;
+	other.cap = 0;
+	other.owned = true;
+}
+
+template<typename T>
+Storage<T>& Storage<T>::operator=(Storage other) noexcept
+{
+	std::swap(memory, other.memory);
+	std::swap(elements, other.elements);
+	std::swap(count, other.count);
+	std::swap(cap, other.cap);
+	std::swap(owned, other.owned);
+	return *this;
+}
+
+template<typename T>
+Storage<T>::~Storage()
+{
+	clear();
+	if(owned && elements != nullptr)
+	{
+		memory->deallocate(elements, cap * sizeof(T), alignof(T));
+	}
+}
+
+// constructs a new element at the end of the array
+template<typename T>
+template<typename... Args>
+T& Storage<T>::emplaceBack(Args&&... args)
+{
+	if(count == cap)
+	{
+		grow(count + 1);
+	}
+	T* slot = new(elements + count) T{std::forward<Args>(args)...};
+	count++;
+	return *slot;
+}
+
+// destroys the last element
+template<typename T>
+void Storage<T>::popBack()
+{
+	count--;
+	elements[count].~T();
+}
+
+// destroys the element at the given index and fills the gap with the last
+// element. this is the "swap and pop" used when removing from a pool.
+template<typename T>
+void Storage<T>::removeSwap(std::size_t index)
+{
+	std::size_t last = count - 1;
+	if(index != last)
+	{
+		if constexpr (relocatable)
+		{
+			elements[index].~T();
+			relocate(elements + index, elements + last, 1);
+			count--;
+			return;
+		}
+		else
+		{
+			elements[index] = std::move(elements[last]);
+		}
+	}
+	popBack();
+}
+
+// exchanges the positions of two elements
+template<typename T>
+void Storage<T>::swapElements(std::size_t a, std::size_t b)
+{
+	if constexpr (relocatable)
+	{
+		alignas(T) unsigned char temp[sizeof(T)];
+		std::memcpy(temp, static_cast<void*>(elements + a), sizeof(T));
+		std::memcpy(static_cast<void*>(elements + a),
+			static_cast<void*>(elements + b), sizeof(T));
+		std::memcpy(static_cast<void*>(elements + b), temp, sizeof(T));
+	}
+	else
+	{
+		using std::swap;
+		swap(elements[a], elements[b]);
+	}
+}
+
+// relocates every element of another storage onto the end of this one,
+// leaving the other storage empty
+template<typename T>
+void Storage<T>::append(Storage& other)
+{
+	if(count + other.count > cap)
+	{
+		grow(count + other.count);
+	}
+	relocate(elements + count, other.elements, other.count);
+	count += other.count;
+	other.count = 0;
+}
+
+// replaces the contents of the storage with copies of n elements
+template<typename T>
+void Storage<T>::assign(const T* source, std::size_t n)
+{
+	clear();
+	reserve(n);
+	if constexpr (std::is_trivially_copyable_v<T>)
+	{
+		if(n != 0)
+		{
+			std::memcpy(static_cast<void*>(elements),
+				static_cast<const void*>(source), n * sizeof(T));
+		}
+	}
+	else
+	{
+		std::uninitialized_copy(source, source + n, elements);
+	}
+	count = n;
+}
+
+// makes the storage use an existing array of n elements which it doesn't
+// own, such as part of a memory-mapped file, instead of its own memory.
+// the array must outlive the storage or its next reallocation, after which
+// the elements are relocated into memory the storage owns. the elements
+// are never constructed, so only trivially copyable types can be adopted,
+// even if they've been declared TriviallyRelocatable
+template<typename T>
+void Storage<T>::adopt(T* external, std::size_t n)
+{
+	static_assert(relocatable && std::is_trivially_copyable_v<T>,
+		"only trivially copyable elements can be adopted");
+	Storage<T> empty(memory);
+	*this = std::move(empty);
+	elements = external;
+	count = n;
+	cap = n;
+	owned = false;
+}
+
+// ensures the storage can hold at least the given number of elements
+// without reallocating
+template<typename T>
+void Storage<T>::reserve(std::size_t newCap)
+{
+	if(newCap <= cap)
+	{
+		return;
+	}
+	T* newElements = static_cast<T*>
+		(memory->allocate(newCap * sizeof(T), alignof(T)));
+	relocate(newElements, elements, count);
+	if(owned && elements != nullptr)
+	{
+		memory->deallocate(elements, cap * sizeof(T), alignof(T));
+	}
+	elements = newElements;
+	cap = newCap;
+	owned = true;
+}
+
+// reallocates the storage to hold exactly its elements, or frees it if
+// it's empty. adopted memory is already exactly full, so it's kept
+template<typename T>
+void Storage<T>::shrinkToFit()
+{
+	if(count == cap || !owned)
+	{
+		return;
+	}
+	T* newElements = nullptr;
+	if(count != 0)
+	{
+		newElements = static_cast<T*>
+			(memory->allocate(count * sizeof(T), alignof(T)));
+		relocate(newElements, elements, count);
+	}
+	memory->deallocate(elements, cap * sizeof(T), alignof(T));
+	elements = newElements;
+	cap = count;
+}
+
+// destroys all elements, keeping the allocated capacity. adopted memory
+// is let go of instead of being reused.
+template<typename T>
+void Storage<T>::clear()
+{
+	if constexpr (!std::is_trivially_destructible_v<T>)
+	{
+		for(std::size_t i = 0; i < count; i++)
+		{
+			elements[i].~T();
+		}
+	}
+	count = 0;
+	if(!owned)
+	{
+		elements = nullptr;
+		cap = 0;
+		owned = true;
+	}
+}
+
+template<typename T>
+T& Storage<T>::operator[](std::size_t index)
+{
+	return elements[index];
+}
+
+template<typename T>
+const T& Storage<T>::operator[](std::size_t index) const
+{
+	return elements[index];
+}
+
+template<typename T>
+T& Storage<T>::back()
+{
+	return elements[count - 1];
+}
+
+template<typename T>
+const T& Storage<T>::back() const
+{
+	return elements[count - 1];
+}
+
+template<typename T>
+T* Storage<T>::data()
+{
+	return elements;
+}
+
+template<typename T>
+const T* Storage<T>::data() const
+{
+	return elements;
+}
+
+template<typename T>
+std::size_t Storage<T>::size() const
+{
+	return count;
+}
+
+template<typename T>
+std::size_t Storage<T>::capacity() const
+{
+	return cap;
+}
+
+template<typename T>
+bool Storage<T>::empty() const
+{
+	return count == 0;
+}
+
+// returns the memory resource the storage allocates from
+template<typename T>
+std::pmr::memory_resource* Storage<T>::resource() const
+{
+	return memory;
+}
+
+template<typename T>
+T* Storage<T>::begin()
+{
+	return elements;
+}
+
+template<typename T>
+T* Storage<T>::end()
+{
+	return elements + count;
+}
+
+template<typename T>
+const T* Storage<T>::begin() const
+{
+	return elements;
+}
+
+template<typename T>
+const T* Storage<T>::end() const
+{
+	return elements + count;
+}
+
+}
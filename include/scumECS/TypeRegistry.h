@@ -0,0 +1,124 @@
+#pragma once
+
+#include "Types.h"
+#include "Checksum.h"
+#include "Snapshot.h"
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <typeinfo>
+#include <vector>
+
+namespace scum
+{
+
+class Manager;
+class PoolBase;
+
+// names a component type in snapshots and command logs, which outlive the
+// process. specialize it with a name which no other component type uses and
+// which won't change, or use SCUM_TYPE_NAME. without one, the compiler's
+// name for the type is used, which only stays the same between builds from
+// the same compiler.
+template<typename C>
+struct TypeName
+{
+	static constexpr const char* value = nullptr;
+};
+
+// names a component type after itself, e.g. SCUM_TYPE_NAME(game::Position).
+// use it outside of any namespace
+#define SCUM_TYPE_NAME(Type) \
+	template<> \
+	struct scum::TypeName<Type> \
+	{ \
+		static constexpr const char* value = #Type; \
+	}
+
+// describes a component type to code which only knows the type's key, such
+// as snapshot loading. hash is typeid's hash code, which is only used
+// within the process since it can change between builds. key is a hash of
+// the type's name (see TypeName), and is what snapshots and logs store
+struct TypeInfo
+{
+	size_t hash;
+	uint64_t key;
+	const char* name;
+	size_t size;
+	bool rawSnapshot; // stored as a raw array in snapshots
+	bool canSnapshot; // can be stored in snapshots at all
+	PoolBase& (*getPool)(Manager& manager);
+};
+
+template<typename C>
+PoolBase& getPoolOf(Manager& manager);
+
+// a global list of the component types used by the program. a type is
+// registered at startup if Manager::getPool is instantiated for it anywhere,
+// so a fresh process can recreate pools it hasn't touched yet
+class TypeRegistry
+{
+public:
+	template<typename C>
+	static const TypeInfo* get();
+	static const TypeInfo* find(uint64_t key);
+
+private:
+	template<typename C>
+	static const TypeInfo* add();
+	static std::vector<const TypeInfo*>& types();
+
+	template<typename C>
+	static inline const TypeInfo* const registered = add<C>();
+};
+
+// returns the registry entry for a component type
+template<typename C>
+const TypeInfo* TypeRegistry::get()
+{
+	(void)registered<C>; // make sure the type is registered at startup
+	return add<C>();
+}
+
+// returns the registry entry for a type's key, or nullptr if the type
+// isn't known
+inline const TypeInfo* TypeRegistry::find(uint64_t key)
+{
+	for(auto* info : types())
+	{
+		if(info->key == key)
+		{
+			return info;
+		}
+	}
+	return nullptr;
+}
+
+// registers a type the first time it is called, and returns its entry
+template<typename C>
+const TypeInfo* TypeRegistry::add()
+{
+	static const char* name = TypeName<C>::value != nullptr ?
+		TypeName<C>::value : typeid(C).name();
+	static const TypeInfo info{typeid(C).hash_code(),
+		hashBytes(name, std::strlen(name)), name, sizeof(C),
+		scum::rawSnapshot<C>, scum::canSnapshot<C>, &getPoolOf<C>};
+	static const bool added = [&]
+	{
+		// two types with the same key would load into each other's pools
+		assert(find(info.key) == nullptr);
+		types().push_back(&info);
+		return true;
+	}();
+	(void)added;
+	return &info;
+}
+
+inline std::vector<const TypeInfo*>& TypeRegistry::types()
+{
+	static std::vector<const TypeInfo*> list;
+	return list;
+}
+
+}
@@ -1,15 +1,66 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <utility>
 #include <tsl/robin_map.h>
 
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#endif
+
 namespace scum
 {
 
 // the entity ID type
 using ID = uint32_t;
-// the hash table type used for lookup
+// the hash table type used for lookup. it must accept a
+// std::pmr::polymorphic_allocator so that it can share the manager's
+// memory resource, e.g. std::pmr::unordered_map<K,V>
 template<typename K, typename V>
-using AssocContainer = tsl::robin_map<K,V>;
+using AssocContainer = tsl::robin_map<K, V, std::hash<K>, std::equal_to<K>,
+	std::pmr::polymorphic_allocator<std::pair<K,V>>>;
 const ID Null = 0;
+// new IDs are handed out in steps of this size. the bits below it count
+// how many times an ID's slot has been recycled
+const ID IDStride = 4096;
+const unsigned IDStrideBits = 12;
+static_assert(IDStride == ID(1) << IDStrideBits);
+// the most IDs which can be live at once, since each needs its own slot
+const uint64_t MaxIDs = (uint64_t(1) << (sizeof(ID) * 8)) / IDStride;
+
+// returns the slot an ID occupies. all recycled versions of an ID share it,
+// and no two live IDs ever share one
+inline ID slotOf(ID id)
+{
+	return id / IDStride;
+}
+
+// hashes IDs for the lookup tables in pools. std::hash<ID> is the identity,
+// and freshly created IDs are all multiples of IDStride, so tables which
+// pick buckets with the low bits of the hash put them all in one bucket.
+// folding the slot into the low bits spreads live IDs, which never share a
+// slot, evenly over the buckets, and leaves small sequential IDs as they are
+struct IDHash
+{
+	size_t operator()(ID id) const
+	{
+		return id ^ (id >> IDStrideBits);
+	}
+};
+
+// hints that the memory at an address will be read soon, so that its cache
+// miss can overlap with other work. does nothing where unsupported
+inline void prefetch(const void* address)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	__builtin_prefetch(address);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	_mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#else
+	(void)address;
+#endif
+}
 
 }
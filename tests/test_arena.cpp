@@ -0,0 +1,125 @@
+#include "scumECS/ECS.h"
+#include <cstdlib>
+#include <memory_resource>
+#include <new>
+#include <vector>
+
+// counts every allocation made with operator new, to catch any which bypass
+// memory resources entirely
+static size_t heapAllocations = 0;
+
+void* operator new(std::size_t size)
+{
+	heapAllocations++;
+	if(void* p = std::malloc(size == 0 ? 1 : size))
+	{
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+struct Velocity
+{
+	float x;
+	float y;
+};
+
+struct Health
+{
+	int value;
+};
+
+int main()
+{
+	std::pmr::monotonic_buffer_resource arena;
+	// any allocation which bypasses the arena will now throw
+	std::pmr::set_default_resource(std::pmr::null_memory_resource());
+
+	scum::Manager manager(&arena);
+	for(int i = 0; i < 1000; i++)
+	{
+		auto id = manager.newID();
+		manager.add<Velocity>(id, 1.0f, 2.0f);
+		if(i % 2 == 0)
+		{
+			manager.queueAdd<Health>(id, i);
+		}
+		if(i % 3 == 0)
+		{
+			manager.queueDestroy(id);
+		}
+	}
+	manager.processQueues();
+
+	int count = 0;
+	for(auto id : manager.search<Velocity, Health>())
+	{
+		if(manager.get<Health>(id)->value % 2 != 0)
+		{
+			return -1;
+		}
+		count++;
+	}
+	// entities divisible by 2 but not by 3
+	if(count != 333)
+	{
+		return -1;
+	}
+
+	// with budgets set, frames of churn don't allocate at all once the
+	// pools exist
+	scum::CountingResource counter(std::pmr::new_delete_resource());
+	scum::Manager budgeted(&counter);
+	budgeted.setBudget(300, 50);
+	budgeted.setBudget<Velocity>(300, 50);
+	budgeted.setBudget<Health>(300, 50);
+	std::vector<scum::ID> live;
+	live.reserve(300);
+	size_t heapBefore = 0;
+	for(int frame = 0; frame < 100; frame++)
+	{
+		if(frame == 10)
+		{
+			counter.mark();
+			heapBefore = heapAllocations;
+		}
+		for(int i = 0; i < 20 && live.size() < 250; i++)
+		{
+			auto id = budgeted.newID();
+			live.push_back(id);
+			budgeted.add<Velocity>(id, 1.0f, 0.0f);
+			budgeted.queueAdd<Health>(id, i);
+		}
+		for(int i = 0; i < 15; i++)
+		{
+			budgeted.queueDestroy(live[(frame * 7 + i) % live.size()]);
+		}
+		budgeted.processQueues();
+		live.clear();
+		for(auto id : budgeted.search<Velocity>())
+		{
+			live.push_back(id);
+		}
+		for(auto id : budgeted.search<Velocity, Health>())
+		{
+			budgeted.get<Health>(id)->value++;
+		}
+	}
+	if(counter.allocations() == 0 || counter.allocationsSinceMark() != 0 ||
+		heapAllocations != heapBefore)
+	{
+		return -1;
+	}
+	counter.assertNoAllocationsSinceMark();
+	return 0;
+}
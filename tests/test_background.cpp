@@ -0,0 +1,34 @@
+#include "scumECS/ECS.h"
+#include <cstdio>
+
+struct Position
+{
+	float x;
+	float y;
+};
+
+int main()
+{
+	// background snapshots see the world as it was when they started
+	const char* path = "test_background.bin";
+	scum::Manager world;
+	auto mover = world.newID();
+	world.add<Position>(mover, 8.0f, 0.0f);
+	for(int i = 0; i < 100; i++)
+	{
+		world.add<Position>(world.newID(), float(i), 0.0f);
+	}
+	auto job = world.saveInBackground(path);
+	world.get<Position>(mover)->x = 50.0f;
+	{
+		scum::Manager loaded;
+		if(!job.wait() || !job.done() || !loaded.load(path) ||
+			loaded.get<Position>(mover)->x != 8.0f ||
+			loaded.getPool<Position>().size() != 101)
+		{
+			return -1;
+		}
+	}
+	std::remove(path);
+	return 0;
+}
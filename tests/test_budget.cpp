@@ -0,0 +1,42 @@
+#include "scumECS/ECS.h"
+#include <vector>
+
+struct Position
+{
+	int x;
+	int y;
+};
+
+int main()
+{
+	// pools with a budget reserve everything up front and never grow
+	{
+		scum::Manager budgeted;
+		budgeted.setBudget(600, 100);
+		budgeted.setBudget<Position>(600, 100);
+		auto before = budgeted.getPool<Position>().stats();
+		std::vector<scum::ID> live;
+		for(int frame = 0; frame < 50; frame++)
+		{
+			for(int i = 0; i < 100 && live.size() < 500; i++)
+			{
+				live.push_back(budgeted.newID());
+				budgeted.queueAdd<Position>(live.back(), frame, i);
+			}
+			for(int i = 0; i < 10 * (frame % 3); i++)
+			{
+				budgeted.queueDestroy(live.back());
+				live.pop_back();
+			}
+			budgeted.processQueues();
+		}
+		auto after = budgeted.getPool<Position>().stats();
+		if(after.count != live.size() || after.capacity != before.capacity ||
+			after.lookupBuckets != before.lookupBuckets ||
+			after.queueBytes != before.queueBytes || before.capacity < 600)
+		{
+			return -1;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,76 @@
+#include "scumECS/ECS.h"
+#include <string>
+#include <vector>
+
+struct Position
+{
+	float x;
+	float y;
+};
+
+struct Name
+{
+	std::string text;
+};
+
+template<>
+struct scum::Serializer<Name>
+{
+	static void write(const Name& name, scum::SnapshotWriter& out)
+	{
+		out.write(name.text.data(), name.text.size());
+	}
+	static Name read(scum::SnapshotReader& in)
+	{
+		size_t size = in.remaining();
+		return Name{std::string(in.take(size), size)};
+	}
+};
+
+int main()
+{
+	scum::Manager manager;
+	std::vector<scum::ID> ids;
+	for(int i = 0; i < 100; i++)
+	{
+		auto id = manager.newID();
+		ids.push_back(id);
+		manager.add<Position>(id, float(i), 0.0f);
+		manager.add<Name>(id, "entity " + std::to_string(i));
+	}
+	manager.disable(ids[1]);
+	manager.destroy(ids[2]);
+
+	// a copy loaded from a snapshot has the same checksum
+	std::vector<char> buffer;
+	scum::SnapshotWriter out(buffer);
+	scum::Manager copy;
+	if(!manager.save(out))
+	{
+		return -1;
+	}
+	scum::SnapshotReader in(buffer.data(), buffer.size());
+	if(!copy.load(in) || copy.checksum() != manager.checksum())
+	{
+		return -1;
+	}
+
+	// checksums notice a single changed component, and only in its pool
+	copy.get<Name>(ids[5])->text = "changed";
+	if(copy.checksum() == manager.checksum() ||
+		copy.getPool<Position>().checksum() !=
+		manager.getPool<Position>().checksum() ||
+		copy.getPool<Name>().checksum() == manager.getPool<Name>().checksum())
+	{
+		return -1;
+	}
+
+	// and a changed enabled set, even with the same components
+	copy.get<Name>(ids[5])->text = "entity 5";
+	copy.enable(ids[1]);
+	if(copy.checksum() == manager.checksum())
+	{
+		return -1;
+	}
+	return 0;
+}
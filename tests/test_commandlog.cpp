@@ -0,0 +1,69 @@
+#include "scumECS/ECS.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+struct Position
+{
+	float x;
+	float y;
+};
+
+struct Name
+{
+	std::string text;
+};
+
+template<>
+struct scum::Serializer<Name>
+{
+	static void write(const Name& name, scum::SnapshotWriter& out)
+	{
+		out.write(name.text.data(), name.text.size());
+	}
+	static Name read(scum::SnapshotReader& in)
+	{
+		size_t size = in.remaining();
+		return Name{std::string(in.take(size), size)};
+	}
+};
+
+int main()
+{
+	// replaying a command log rebuilds the same world
+	scum::CommandLog log;
+	scum::Manager recorded;
+	recorded.record(&log);
+	std::vector<scum::ID> logged;
+	for(int i = 0; i < 50; i++)
+	{
+		auto id = recorded.newID();
+		logged.push_back(id);
+		recorded.add<Position>(id, float(i), 0.0f);
+		recorded.queueAdd<Name>(id, "queued " + std::to_string(i));
+	}
+	recorded.disable(logged[1]);
+	recorded.add<Name>(recorded.newID(), "late");
+	recorded.remove<Position>(logged[2]);
+	recorded.queueDestroy(logged[3]);
+	recorded.processQueues();
+	recorded.destroy(logged[4]);
+	recorded.enable(logged[1]);
+	recorded.record(nullptr);
+
+	const char* path = "test_commandlog.log";
+	scum::CommandLog loadedLog;
+	scum::Manager replayed;
+	std::vector<char> original;
+	std::vector<char> copy;
+	scum::SnapshotWriter originalOut(original);
+	scum::SnapshotWriter copyOut(copy);
+	if(!log.good() || !log.save(path) || !loadedLog.load(path) ||
+		!replayed.replay(loadedLog) || !recorded.save(originalOut) ||
+		!replayed.save(copyOut) || original != copy)
+	{
+		return -1;
+	}
+	std::remove(path);
+	return 0;
+}
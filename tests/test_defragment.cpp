@@ -0,0 +1,125 @@
+#include "scumECS/ECS.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+struct Position
+{
+	int x;
+	int y;
+};
+
+struct Name
+{
+	std::string text;
+};
+
+// adds positions and names to 1000 entities, then removes every other
+// entity's components, which leaves the pools out of slot order
+std::vector<scum::ID> populate(scum::Manager& manager)
+{
+	std::vector<scum::ID> ids;
+	for(int i = 0; i < 1000; i++)
+	{
+		auto id = manager.newID();
+		ids.push_back(id);
+		manager.add<Position>(id, i, -i);
+		manager.add<Name>(id, std::to_string(i));
+	}
+	for(int i = 0; i < 1000; i += 2)
+	{
+		manager.remove<Position>(ids[i]);
+		manager.remove<Name>(ids[i]);
+	}
+	return ids;
+}
+
+// checks that a pool's entities are in ascending slot order
+bool inSlotOrder(const scum::PoolBase& pool)
+{
+	for(auto it = pool.entityBegin(); it + 1 < pool.entityEnd(); ++it)
+	{
+		if(scum::slotOf(*it) >= scum::slotOf(*(it + 1)))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+int main()
+{
+	// defragment by slot a little at a time, which puts back the order
+	// removals have shuffled
+	{
+		scum::Manager manager;
+		populate(manager);
+		auto& positions = manager.getPool<Position>();
+		auto& names = manager.getPool<Name>();
+		if(inSlotOrder(positions))
+		{
+			return -1;
+		}
+		int steps = 0;
+		while(!manager.defragment(std::chrono::nanoseconds(0)))
+		{
+			steps++;
+		}
+		if(steps == 0 || !inSlotOrder(positions) || !inSlotOrder(names))
+		{
+			return -1;
+		}
+		for(auto pair : positions)
+		{
+			if(manager.get<Name>(pair.id)->text != std::to_string(pair.data.x))
+			{
+				return -1;
+			}
+		}
+	}
+
+	// large pools are keyed, sorted and placed over many bounded steps
+	{
+		scum::Manager large;
+		for(int i = 0; i < 10000; i++)
+		{
+			large.add<Position>(large.newID(), i, 0);
+		}
+		auto reversed = [](scum::ID id) { return ~scum::slotOf(id); };
+		int steps = 0;
+		while(!large.defragment(reversed, std::chrono::nanoseconds(0)))
+		{
+			steps++;
+		}
+		auto& pool = large.getPool<Position>();
+		int x = 10000;
+		for(auto pair : pool)
+		{
+			if(pair.data.x != --x)
+			{
+				return -1;
+			}
+		}
+		if(x != 0 || steps < 3 * 10000 / 1024)
+		{
+			return -1;
+		}
+	}
+
+	// pools left empty, or with every component disabled, are passed over
+	{
+		scum::Manager sparse;
+		scum::ID id = sparse.newID();
+		sparse.add<Position>(id, 1, 2);
+		sparse.add<Name>(id, "a");
+		sparse.remove<Position>(id);
+		sparse.disable(id);
+		sparse.processQueues();
+		if(!sparse.defragment(std::chrono::nanoseconds(0)) ||
+			sparse.getPool<Name>().size() != 1)
+		{
+			return -1;
+		}
+	}
+	return 0;
+}
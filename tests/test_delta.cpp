@@ -0,0 +1,125 @@
+#include "scumECS/ECS.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+struct Position
+{
+	float x;
+	float y;
+};
+
+struct Name
+{
+	std::string text;
+};
+
+template<>
+struct scum::Serializer<Name>
+{
+	static void write(const Name& name, scum::SnapshotWriter& out)
+	{
+		out.write(name.text.data(), name.text.size());
+	}
+	static Name read(scum::SnapshotReader& in)
+	{
+		size_t size = in.remaining();
+		return Name{std::string(in.take(size), size)};
+	}
+};
+
+int main()
+{
+	scum::Manager manager;
+	std::vector<scum::ID> ids;
+	for(int i = 0; i < 500; i++)
+	{
+		auto id = manager.newID();
+		ids.push_back(id);
+		manager.add<Position>(id, float(i), float(-i));
+		if(i % 3 == 0)
+		{
+			manager.add<Name>(id, "entity " + std::to_string(i));
+		}
+		if(i % 7 == 0)
+		{
+			manager.disable(id);
+		}
+	}
+	for(int i = 0; i < 500; i += 5)
+	{
+		manager.destroy(ids[i]);
+	}
+	std::vector<char> earlier;
+	scum::SnapshotWriter earlierOut(earlier);
+	if(!manager.save(earlierOut))
+	{
+		return -1;
+	}
+
+	// a delta rebuilds a later snapshot exactly from an earlier one
+	manager.get<Position>(ids[1])->x = 100.0f;
+	manager.get<Name>(ids[3])->text = "renamed";
+	manager.destroy(ids[2]);
+	auto added = manager.newID();
+	manager.add<Position>(added, 1.0f, 1.0f);
+	manager.add<Name>(added, "added");
+	std::vector<char> later;
+	scum::SnapshotWriter laterOut(later);
+	std::vector<char> delta;
+	std::vector<char> rebuilt;
+	std::vector<scum::ID> removed;
+	if(!manager.save(laterOut) || !scum::Delta::make(earlier, later, delta) ||
+		!scum::Delta::apply(earlier, delta, rebuilt) || rebuilt != later ||
+		delta.size() * 10 > later.size() ||
+		!scum::Delta::removedIDs(delta, removed) || removed.empty() ||
+		removed[0] != ids[2])
+	{
+		return -1;
+	}
+
+	// deltas whose pool headers don't match their ops are rejected without
+	// allocating what the header claims
+	{
+		scum::SnapshotHeader header;
+		std::memcpy(&header, later.data(), sizeof(header));
+		auto align = [](size_t n)
+		{
+			return (n + scum::SnapshotAlignment - 1) /
+				scum::SnapshotAlignment * scum::SnapshotAlignment;
+		};
+		size_t poolOffset = align(sizeof(header)) +
+			align(header.freeIDCount * sizeof(scum::ID)) +
+			align(header.disabledIDCount * sizeof(scum::ID));
+		// the delta stores the later snapshot's pool headers as they are
+		auto at = std::search(delta.begin(), delta.end(),
+			later.begin() + poolOffset,
+			later.begin() + poolOffset + sizeof(scum::PoolHeader));
+		if(at == delta.end())
+		{
+			return -1;
+		}
+		size_t deltaOffset = at - delta.begin();
+		auto rejected = [&](void (*corrupt)(scum::PoolHeader&))
+		{
+			std::vector<char> bytes = delta;
+			scum::PoolHeader pool;
+			std::memcpy(&pool, bytes.data() + deltaOffset, sizeof(pool));
+			corrupt(pool);
+			std::memcpy(bytes.data() + deltaOffset, &pool, sizeof(pool));
+			std::vector<char> out;
+			return !scum::Delta::apply(earlier, bytes, out);
+		};
+		if(!rejected([](scum::PoolHeader& p) { p.count = 1ull << 44; }) ||
+			!rejected([](scum::PoolHeader& p) { p.count = 1ull << 62; }) ||
+			!rejected([](scum::PoolHeader& p) { p.count -= 1; }) ||
+			!rejected([](scum::PoolHeader& p) { p.active = p.count + 1; }) ||
+			!rejected([](scum::PoolHeader& p) { p.componentBytes = ~0ull; }) ||
+			!rejected([](scum::PoolHeader& p) { p.componentBytes -= 8; }))
+		{
+			return -1;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,124 @@
+#include "scumECS/ECS.h"
+#include <vector>
+
+struct Transform
+{
+	int x;
+};
+
+struct Body
+{
+	int mass;
+};
+
+int main()
+{
+	scum::Manager manager;
+	std::vector<scum::ID> ids;
+	for(int i = 0; i < 100; i++)
+	{
+		auto id = manager.newID();
+		ids.push_back(id);
+		manager.add<Transform>(id, i);
+		manager.add<Body>(id, i);
+	}
+
+	// put every entity divisible by 4 to sleep
+	for(int i = 0; i < 100; i += 4)
+	{
+		manager.disable(ids[i]);
+	}
+	// components added to a disabled entity start out disabled
+	auto sleeper = manager.newID();
+	manager.disable(sleeper);
+	manager.add<Transform>(sleeper, -1);
+	manager.queueAdd<Body>(sleeper, -1);
+	auto waker = manager.newID();
+	manager.add<Transform>(waker, 1000);
+	manager.queueAdd<Body>(waker, 1000);
+	manager.processQueues();
+
+	// removals and destruction must keep the partition intact
+	manager.remove<Body>(ids[1]);
+	manager.remove<Body>(ids[4]);
+	manager.destroy(ids[2]);
+	manager.destroy(ids[8]);
+
+	auto& transforms = manager.getPool<Transform>();
+	if(transforms.size() != 100 || transforms.activeSize() != 75)
+	{
+		return -1;
+	}
+	for(auto pair : transforms)
+	{
+		if(pair.data.x < 0 || (pair.data.x % 4 == 0 && pair.data.x != 1000) ||
+			pair.data.x != manager.get<Transform>(pair.id)->x)
+		{
+			return -1;
+		}
+	}
+
+	int count = 0;
+	for(auto id : manager.search<Transform, Body>())
+	{
+		if(!manager.isEnabled(id) ||
+			manager.get<Transform>(id)->x != manager.get<Body>(id)->mass)
+		{
+			return -1;
+		}
+		count++;
+	}
+	// 75 awake entities from the loop, minus ids[1] and ids[2], plus waker
+	if(count != 74)
+	{
+		return -1;
+	}
+
+	// waking everything up makes all components visible again
+	for(int i = 0; i < 100; i += 4)
+	{
+		manager.enable(ids[i]);
+	}
+	manager.enable(sleeper);
+	count = 0;
+	for(auto id : manager.search<Transform, Body>())
+	{
+		(void)id;
+		count++;
+	}
+	// 100 entities minus ids[1], ids[2], ids[4] and ids[8], plus two new ones
+	if(count != 98 || manager.get<Body>(sleeper)->mass != -1)
+	{
+		return -1;
+	}
+
+	// enabling an entity before its queued additions are applied leaves
+	// them enabled
+	auto riser = manager.newID();
+	manager.add<Transform>(riser, 2000);
+	manager.disable(riser);
+	manager.queueAdd<Body>(riser, 2000);
+	manager.enable(riser);
+	manager.processQueues();
+	bool found = false;
+	for(auto id : manager.search<Transform, Body>())
+	{
+		found |= id == riser;
+	}
+	if(!manager.isEnabled(riser) || !found)
+	{
+		return -1;
+	}
+
+	// pools ignore requests to enable or disable entities they don't hold
+	auto& bodies = manager.getPool<Body>();
+	size_t enabled = bodies.activeSize();
+	auto stranger = manager.newID();
+	bodies.enable(stranger);
+	bodies.disable(stranger);
+	if(bodies.activeSize() != enabled || bodies.contains(stranger))
+	{
+		return -1;
+	}
+	return 0;
+}
@@ -0,0 +1,99 @@
+#include "scumECS/ECS.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+struct Position
+{
+	int x;
+	int y;
+};
+
+struct Name
+{
+	std::string text;
+};
+
+int main()
+{
+	scum::Manager manager;
+	std::vector<scum::ID> ids;
+	for(int i = 0; i < 1000; i++)
+	{
+		auto id = manager.newID();
+		ids.push_back(id);
+		manager.add<Position>(id, i, -i);
+		manager.add<Name>(id, std::to_string(i));
+	}
+	for(int i = 0; i < 1000; i += 2)
+	{
+		manager.remove<Position>(ids[i]);
+		manager.remove<Name>(ids[i]);
+	}
+
+	// forks read their parent's pools and only copy the ones they change
+	{
+		scum::CountingResource counting;
+		auto fork = manager.fork(&counting);
+		const auto& view = fork;
+		counting.mark();
+		size_t found = 0;
+		for(auto id : fork.search<Position, Name>())
+		{
+			auto* pos = view.get<Position>(id);
+			if(view.get<Name>(id)->text != std::to_string(pos->x))
+			{
+				return -1;
+			}
+			found++;
+		}
+		if(found != 500 || !fork.contains<Name>(ids[5]) ||
+			view.tryGet<Name>(ids[4]) != nullptr ||
+			view.getPool<Position>().size() != 500 ||
+			counting.allocationsSinceMark() != 0)
+		{
+			return -1;
+		}
+		fork.get<Position>(ids[1])->x = 100;
+		if(counting.allocationsSinceMark() == 0 ||
+			manager.get<Position>(ids[1])->x != 1)
+		{
+			return -1;
+		}
+	}
+
+
+	// forks copy pools as they change them and leave their parent alone
+	{
+		auto fork = manager.fork();
+		fork.get<Position>(ids[1])->x = 100;
+		fork.destroy(ids[3]);
+		auto nested = fork.fork();
+		nested.remove<Name>(ids[5]);
+		if(manager.get<Position>(ids[1])->x != 1 ||
+			!manager.contains<Name>(ids[3]) || !fork.contains<Name>(ids[5]) ||
+			nested.contains<Position>(ids[3]) || nested.contains<Name>(ids[5]) ||
+			nested.get<Position>(ids[1])->x != 100 ||
+			nested.getPool<Name>().size() != 498)
+		{
+			return -1;
+		}
+		// moving a fork keeps it reading from the same parent
+		auto moved = std::move(nested);
+		if(moved.get<Position>(ids[1])->x != 100 ||
+			moved.contains<Name>(ids[5]) || !moved.contains<Name>(ids[7]))
+		{
+			return -1;
+		}
+	}
+
+	// once its forks are gone, the parent can be changed again, which
+	// asserts while any are left
+	manager.destroy(ids[1]);
+	manager.processQueues();
+	if(manager.contains<Position>(ids[1]))
+	{
+		return -1;
+	}
+	return 0;
+}
@@ -0,0 +1,108 @@
+#include "scumECS/ECS.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+struct Position
+{
+	int x;
+	int y;
+};
+
+struct Name
+{
+	std::string text;
+};
+
+int main()
+{
+	scum::Manager manager;
+	std::vector<scum::ID> ids;
+	for(int i = 0; i < 1000; i++)
+	{
+		auto id = manager.newID();
+		ids.push_back(id);
+		manager.add<Position>(id, i, -i);
+		manager.queueAdd<Name>(id, std::to_string(i));
+	}
+	manager.processQueues();
+
+	// remove every other entity's components, forcing swap-and-pop
+	for(int i = 0; i < 1000; i += 2)
+	{
+		manager.remove<Position>(ids[i]);
+		manager.remove<Name>(ids[i]);
+	}
+
+	if(manager.getPool<Position>().size() != 500 ||
+		manager.getPool<Name>().size() != 500)
+	{
+		return -1;
+	}
+	for(int i = 1; i < 1000; i += 2)
+	{
+		auto* pos = manager.get<Position>(ids[i]);
+		auto* name = manager.get<Name>(ids[i]);
+		if(pos->x != i || pos->y != -i || name->text != std::to_string(i))
+		{
+			return -1;
+		}
+	}
+	for(auto pair : manager.getPool<Name>())
+	{
+		if(pair.data.text != std::to_string(manager.get<Position>(pair.id)->x))
+		{
+			return -1;
+		}
+	}
+
+	// batched lookups match one at a time lookups, including misses
+	{
+		std::vector<scum::ID> batch(ids.rbegin(), ids.rend());
+		batch.push_back(scum::Null);
+		std::vector<Position*> found(batch.size());
+		manager.getMany<Position>(batch.data(), batch.size(), found.data());
+		for(size_t i = 0; i < batch.size(); i++)
+		{
+			if(found[i] != manager.tryGet<Position>(batch[i]))
+			{
+				return -1;
+			}
+		}
+	}
+
+	// lookups survive heavy churn, which leaves tombstones in hash tables
+	{
+		scum::Manager churn;
+		std::vector<scum::ID> live;
+		for(int round = 0; round < 20; round++)
+		{
+			for(int i = 0; i < 300; i++)
+			{
+				auto id = churn.newID();
+				live.push_back(id);
+				churn.add<Position>(id, round, i);
+			}
+			for(size_t i = 0; i < live.size(); i += 2)
+			{
+				churn.destroy(live[i]);
+				live[i] = scum::Null;
+			}
+			live.erase(std::remove(live.begin(), live.end(), scum::Null),
+				live.end());
+			for(auto id : live)
+			{
+				if(!churn.contains<Position>(id))
+				{
+					return -1;
+				}
+			}
+		}
+		if(churn.getPool<Position>().size() != live.size())
+		{
+			return -1;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,42 @@
+#include "scumECS/ECS.h"
+#include <string>
+
+struct Position
+{
+	int x;
+	int y;
+};
+
+int main()
+{
+	// profiled scopes are exported as trace events
+	{
+		scum::ProfileScope scope("test \"scope\"");
+	}
+	std::string trace = scum::Profiler::traceJSON();
+	if(trace.find("\"name\":\"test \\\"scope\\\"\",\"ph\":\"X\"") ==
+		std::string::npos)
+	{
+		return -1;
+	}
+
+	// the library's own phases are profiled when SCUM_PROFILE is defined
+	scum::Manager manager;
+	manager.queueAdd<Position>(manager.newID(), 1, 2);
+	manager.processQueues();
+	trace = scum::Profiler::traceJSON();
+	if(trace.find("\"name\":\"scum::Manager::processQueues\"") ==
+		std::string::npos)
+	{
+		return -1;
+	}
+
+	// clearing forgets every event
+	scum::Profiler::clear();
+	trace = scum::Profiler::traceJSON();
+	if(trace.find("processQueues") != std::string::npos)
+	{
+		return -1;
+	}
+	return 0;
+}
@@ -0,0 +1,61 @@
+#include "scumECS/ECS.h"
+#include <vector>
+
+struct Position
+{
+	int x;
+	int y;
+};
+
+int main()
+{
+	// reserving grows everything once, and shrinking gives back what's spare
+	{
+		scum::Manager level;
+		level.reserveEntities(2000, 100);
+		level.reserve<Position>(2000, 100);
+		auto reserved = level.getPool<Position>().stats();
+		std::vector<scum::ID> live;
+		for(int i = 0; i < 2000; i++)
+		{
+			live.push_back(level.newID());
+			level.add<Position>(live.back(), i, 0);
+		}
+		auto full = level.getPool<Position>().stats();
+		if(reserved.capacity < 2000 || full.capacity != reserved.capacity ||
+			full.lookupBuckets != reserved.lookupBuckets)
+		{
+			return -1;
+		}
+		// destroy the newest, since slot-indexed lookups only shrink down to
+		// the highest slot still in use
+		for(int i = 100; i < 2000; i++)
+		{
+			level.destroy(live[i]);
+		}
+		size_t managerBytes = level.stats().managerBytes;
+		level.shrinkToFit();
+		auto shrunk = level.getPool<Position>().stats();
+		if(shrunk.capacity != 100 || shrunk.queueBytes != 0 ||
+			shrunk.lookupBuckets >= full.lookupBuckets ||
+			level.stats().managerBytes >= managerBytes)
+		{
+			return -1;
+		}
+		for(int i = 0; i < 100; i++)
+		{
+			if(level.get<Position>(live[i])->x != i)
+			{
+				return -1;
+			}
+			level.destroy(live[i]);
+		}
+		level.shrinkToFit();
+		auto empty = level.getPool<Position>().stats();
+		if(empty.capacity != 0 || empty.lookupBuckets >= shrunk.lookupBuckets)
+		{
+			return -1;
+		}
+	}
+	return 0;
+}
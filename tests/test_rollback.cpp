@@ -0,0 +1,70 @@
+#include "scumECS/ECS.h"
+#include <vector>
+
+struct Position
+{
+	float x;
+	float y;
+};
+
+int main()
+{
+	// frames can be rolled back and simulated again
+	{
+		scum::Manager world;
+		scum::Rollback rollback(4);
+		auto mover = world.newID();
+		world.add<Position>(mover, 0.0f, 0.0f);
+		for(uint64_t frame = 0; frame < 10; frame++)
+		{
+			rollback.capture(world, frame);
+			world.get<Position>(mover)->x += 1.0f;
+			world.add<Position>(world.newID(), 0.0f, 0.0f);
+		}
+		if(rollback.contains(5) || !rollback.restore(world, 7) ||
+			world.get<Position>(mover)->x != 7.0f ||
+			world.getPool<Position>().size() != 8)
+		{
+			return -1;
+		}
+		// restoring again reuses the pool's memory
+		auto* storage = world.get<Position>(mover);
+		if(!rollback.restore(world, 8) ||
+			world.get<Position>(mover) != storage || storage->x != 8.0f)
+		{
+			return -1;
+		}
+	}
+
+	// restoring puts back entities which have since moved within their pools
+	{
+		scum::Manager moving;
+		std::vector<scum::ID> all;
+		for(int i = 0; i < 100; i++)
+		{
+			all.push_back(moving.newID());
+			moving.add<Position>(all.back(), float(i), 0.0f);
+		}
+		scum::Rollback frames(2);
+		frames.capture(moving, 0);
+		for(int i = 0; i < 100; i += 3)
+		{
+			moving.destroy(all[i]);
+		}
+		moving.add<Position>(moving.newID(), -1.0f, 0.0f);
+		if(!frames.restore(moving, 0) ||
+			moving.getPool<Position>().size() != 100)
+		{
+			return -1;
+		}
+		for(int i = 0; i < 100; i++)
+		{
+			auto* pos = moving.tryGet<Position>(all[i]);
+			if(pos == nullptr || pos->x != float(i))
+			{
+				return -1;
+			}
+		}
+	}
+	return 0;
+}
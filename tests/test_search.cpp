@@ -1,5 +1,6 @@
 #include "scumECS/ECS.h"
 #include <string>
+#include <vector>
 
 struct String
 {
@@ -33,6 +34,7 @@ int main()
 	}
 
 	auto search = manager.search<Fizz, Buzz>();
+	int found = 0;
 	for(auto id : search)
 	{
 		auto* cmp = manager.get<String>(id);
@@ -40,5 +42,83 @@ int main()
 		{
 			return -1;
 		}
+		found++;
 	}
+	if(found != 7)
+	{
+		return -1;
+	}
+
+	// the first candidate is skipped if it doesn't match
+	manager.remove<Fizz>(*manager.search<Fizz, Buzz>().begin());
+	found = 0;
+	for(auto id : manager.search<Fizz, Buzz>())
+	{
+		if(!manager.contains<Fizz>(id))
+		{
+			return -1;
+		}
+		found++;
+	}
+	if(found != 6)
+	{
+		return -1;
+	}
+
+	// prefetching ahead doesn't change what a search finds
+	std::vector<scum::ID> plain;
+	std::vector<scum::ID> prefetched;
+	for(auto id : manager.search<String, Fizz, Buzz>())
+	{
+		plain.push_back(id);
+	}
+	for(auto id : manager.search<String, Fizz, Buzz>().withPrefetch())
+	{
+		prefetched.push_back(id);
+	}
+	if(plain.size() != 6 || prefetched != plain)
+	{
+		return -1;
+	}
+	// searches which have been stored are switched over in place
+	auto stored = manager.search<String, Fizz, Buzz>();
+	stored.withPrefetch();
+	prefetched.clear();
+	for(auto id : stored)
+	{
+		prefetched.push_back(id);
+	}
+	if(prefetched != plain)
+	{
+		return -1;
+	}
+
+#ifdef SCUM_SEARCH_TELEMETRY
+	// the Buzz pool drives the search, and each of its entities is checked
+	// against the Fizz pool
+	scum::SearchTelemetry::reset();
+	for(auto id : manager.search<Fizz, Buzz>())
+	{
+		(void)id;
+	}
+	auto& telemetry = scum::Search<Fizz, Buzz>::telemetry();
+	if(telemetry.searches != 1 || telemetry.candidates != 20 ||
+		telemetry.matches != 6 || telemetry.probes[0] != 20 ||
+		telemetry.probes[1] != 0)
+	{
+		return -1;
+	}
+	// prefetching searches are counted once, like any other
+	scum::SearchTelemetry::reset();
+	for(auto id : manager.search<Fizz, Buzz>().withPrefetch())
+	{
+		(void)id;
+	}
+	if(telemetry.searches != 1 || telemetry.candidates != 20 ||
+		telemetry.matches != 6)
+	{
+		return -1;
+	}
+#endif
+	return 0;
 }
@@ -0,0 +1,140 @@
+#include "scumECS/ECS.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+struct Position
+{
+	float x;
+	float y;
+};
+
+SCUM_TYPE_NAME(Position);
+
+struct Name
+{
+	std::string text;
+};
+
+template<>
+struct scum::Serializer<Name>
+{
+	static void write(const Name& name, scum::SnapshotWriter& out)
+	{
+		out.write(name.text.data(), name.text.size());
+	}
+	static Name read(scum::SnapshotReader& in)
+	{
+		size_t size = in.remaining();
+		return Name{std::string(in.take(size), size)};
+	}
+};
+
+// checks that two managers hold the same entities and components
+bool same(scum::Manager& a, scum::Manager& b, const std::vector<scum::ID>& ids)
+{
+	for(auto id : ids)
+	{
+		auto* posA = a.tryGet<Position>(id);
+		auto* posB = b.tryGet<Position>(id);
+		auto* nameA = a.tryGet<Name>(id);
+		auto* nameB = b.tryGet<Name>(id);
+		if((posA == nullptr) != (posB == nullptr) ||
+			(nameA == nullptr) != (nameB == nullptr) ||
+			a.isEnabled(id) != b.isEnabled(id))
+		{
+			return false;
+		}
+		if(posA != nullptr && (posA->x != posB->x || posA->y != posB->y))
+		{
+			return false;
+		}
+		if(nameA != nullptr && nameA->text != nameB->text)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+int main()
+{
+	scum::Manager manager;
+	std::vector<scum::ID> ids;
+	for(int i = 0; i < 500; i++)
+	{
+		auto id = manager.newID();
+		ids.push_back(id);
+		manager.add<Position>(id, float(i), float(-i));
+		if(i % 3 == 0)
+		{
+			manager.add<Name>(id, "entity " + std::to_string(i));
+		}
+		if(i % 7 == 0)
+		{
+			manager.disable(id);
+		}
+	}
+	for(int i = 0; i < 500; i += 5)
+	{
+		manager.destroy(ids[i]);
+	}
+
+	const char* path = "test_snapshot.bin";
+	if(!manager.save(path))
+	{
+		return -1;
+	}
+	std::vector<char> buffer;
+	scum::SnapshotWriter out(buffer);
+	if(!manager.save(out))
+	{
+		return -1;
+	}
+	// named types are stored by a hash of their name, which doesn't depend
+	// on the build, and unnamed ones by a hash of the compiler's name
+	auto* info = scum::TypeRegistry::get<Position>();
+	uint64_t key = scum::hashBytes("Position", std::strlen("Position"));
+	const char* keyBytes = reinterpret_cast<const char*>(&key);
+	if(info->key != key || std::strcmp(info->name, "Position") != 0 ||
+		scum::TypeRegistry::find(key) != info ||
+		scum::TypeRegistry::find(scum::TypeRegistry::get<Name>()->key) ==
+		nullptr ||
+		std::search(buffer.begin(), buffer.end(), keyBytes,
+		keyBytes + sizeof(key)) == buffer.end())
+	{
+		return -1;
+	}
+
+	// loaded managers must hand out the same IDs as the original
+	scum::ID nextID = manager.newID();
+
+	// load from the file into a fresh manager, adopting the mapped arrays
+	{
+		scum::Manager loaded;
+		if(!loaded.load(path) || !same(manager, loaded, ids) ||
+			loaded.newID() != nextID)
+		{
+			return -1;
+		}
+		// adopted pools must still be able to grow
+		for(int i = 0; i < 100; i++)
+		{
+			loaded.add<Position>(loaded.newID(), 1.0f, 2.0f);
+		}
+	}
+
+	// load from memory into a manager which already has other state
+	scum::Manager copy;
+	copy.add<Position>(copy.newID(), 5.0f, 5.0f);
+	scum::SnapshotReader in(buffer.data(), buffer.size());
+	if(!copy.load(in) || !same(manager, copy, ids) || copy.newID() != nextID)
+	{
+		return -1;
+	}
+
+	std::remove(path);
+	return 0;
+}
@@ -0,0 +1,163 @@
+#include "scumECS/ECS.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+struct Position
+{
+	float x;
+	float y;
+};
+
+struct Name
+{
+	std::string text;
+};
+
+template<>
+struct scum::Serializer<Name>
+{
+	static void write(const Name& name, scum::SnapshotWriter& out)
+	{
+		out.write(name.text.data(), name.text.size());
+	}
+	static Name read(scum::SnapshotReader& in)
+	{
+		size_t size = in.remaining();
+		return Name{std::string(in.take(size), size)};
+	}
+};
+
+// checks that two managers hold the same entities and components
+bool same(scum::Manager& a, scum::Manager& b, const std::vector<scum::ID>& ids)
+{
+	for(auto id : ids)
+	{
+		auto* posA = a.tryGet<Position>(id);
+		auto* posB = b.tryGet<Position>(id);
+		auto* nameA = a.tryGet<Name>(id);
+		auto* nameB = b.tryGet<Name>(id);
+		if((posA == nullptr) != (posB == nullptr) ||
+			(nameA == nullptr) != (nameB == nullptr) ||
+			a.isEnabled(id) != b.isEnabled(id))
+		{
+			return false;
+		}
+		if(posA != nullptr && (posA->x != posB->x || posA->y != posB->y))
+		{
+			return false;
+		}
+		if(nameA != nullptr && nameA->text != nameB->text)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// fills a manager with positions, some names, some disabled entities and
+// some destroyed ones, and returns the IDs it handed out
+std::vector<scum::ID> populate(scum::Manager& manager)
+{
+	std::vector<scum::ID> ids;
+	for(int i = 0; i < 500; i++)
+	{
+		auto id = manager.newID();
+		ids.push_back(id);
+		manager.add<Position>(id, float(i), float(-i));
+		if(i % 3 == 0)
+		{
+			manager.add<Name>(id, "entity " + std::to_string(i));
+		}
+		if(i % 7 == 0)
+		{
+			manager.disable(id);
+		}
+	}
+	for(int i = 0; i < 500; i += 5)
+	{
+		manager.destroy(ids[i]);
+	}
+	return ids;
+}
+
+int main()
+{
+	scum::Manager manager;
+	auto ids = populate(manager);
+	const char* path = "test_snapshot_validation.bin";
+	std::vector<char> buffer;
+	scum::SnapshotWriter out(buffer);
+	if(!manager.save(path) || !manager.save(out))
+	{
+		return -1;
+	}
+	scum::Manager copy;
+	scum::SnapshotReader in(buffer.data(), buffer.size());
+	if(!copy.load(in))
+	{
+		return -1;
+	}
+
+	// snapshots whose headers don't match their data are rejected before
+	// anything is changed
+	{
+		auto align = [](size_t n)
+		{
+			return (n + scum::SnapshotAlignment - 1) /
+				scum::SnapshotAlignment * scum::SnapshotAlignment;
+		};
+		scum::SnapshotHeader header;
+		std::memcpy(&header, buffer.data(), sizeof(header));
+		size_t poolOffset = align(sizeof(header)) +
+			align(header.freeIDCount * sizeof(scum::ID)) +
+			align(header.disabledIDCount * sizeof(scum::ID));
+		uint64_t checksum = copy.checksum();
+		auto rejected = [&](void (*corrupt)(scum::PoolHeader&))
+		{
+			std::vector<char> bytes = buffer;
+			scum::PoolHeader pool;
+			std::memcpy(&pool, bytes.data() + poolOffset, sizeof(pool));
+			corrupt(pool);
+			std::memcpy(bytes.data() + poolOffset, &pool, sizeof(pool));
+			scum::SnapshotReader reader(bytes.data(), bytes.size());
+			return !copy.load(reader) && copy.checksum() == checksum;
+		};
+		std::vector<char> truncated(buffer.begin(),
+			buffer.begin() + buffer.size() / 2);
+		scum::SnapshotReader reader(truncated.data(), truncated.size());
+		if(copy.load(reader) || copy.checksum() != checksum ||
+			!rejected([](scum::PoolHeader& p) { p.count = ~0ull / 2; }) ||
+			!rejected([](scum::PoolHeader& p) { p.active = p.count + 1; }) ||
+			!rejected([](scum::PoolHeader& p) { p.componentBytes -= 8; }) ||
+			!rejected([](scum::PoolHeader& p) { p.count += 1; }))
+		{
+			return -1;
+		}
+
+		// a manager using a mapped file keeps it when loading another fails
+		const char* badPath = "test_snapshot_bad.bin";
+		std::FILE* file = std::fopen(badPath, "wb");
+		std::fwrite(truncated.data(), 1, truncated.size(), file);
+		std::fclose(file);
+		scum::Manager mapped;
+		if(!mapped.load(path) || mapped.load(badPath) ||
+			!same(manager, mapped, ids))
+		{
+			return -1;
+		}
+		std::remove(badPath);
+	}
+
+	// corrupt snapshots are rejected without touching the manager
+	buffer[0] = 'X';
+	scum::SnapshotReader bad(buffer.data(), buffer.size());
+	if(copy.load(bad) || !same(manager, copy, ids))
+	{
+		return -1;
+	}
+
+	std::remove(path);
+	return 0;
+}
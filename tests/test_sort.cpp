@@ -0,0 +1,63 @@
+#include "scumECS/ECS.h"
+#include <string>
+#include <vector>
+
+struct Position
+{
+	int x;
+	int y;
+};
+
+struct Name
+{
+	std::string text;
+};
+
+// adds positions and names to 1000 entities, then removes every other
+// entity's components, which leaves the pools out of slot order
+std::vector<scum::ID> populate(scum::Manager& manager)
+{
+	std::vector<scum::ID> ids;
+	for(int i = 0; i < 1000; i++)
+	{
+		auto id = manager.newID();
+		ids.push_back(id);
+		manager.add<Position>(id, i, -i);
+		manager.add<Name>(id, std::to_string(i));
+	}
+	for(int i = 0; i < 1000; i += 2)
+	{
+		manager.remove<Position>(ids[i]);
+		manager.remove<Name>(ids[i]);
+	}
+	return ids;
+}
+
+int main()
+{
+	// sort positions by descending x, then line names up with them
+	{
+		scum::Manager manager;
+		populate(manager);
+		auto& positions = manager.getPool<Position>();
+		auto& names = manager.getPool<Name>();
+		positions.sort([](const Position& l, const Position& r)
+		{
+			return l.x > r.x;
+		});
+		names.sortAs(positions);
+		int last = 1000;
+		auto nameIt = names.entityBegin();
+		for(auto pair : positions)
+		{
+			if(pair.data.x >= last || *nameIt != pair.id ||
+				manager.get<Name>(pair.id)->text != std::to_string(pair.data.x))
+			{
+				return -1;
+			}
+			last = pair.data.x;
+			++nameIt;
+		}
+	}
+	return 0;
+}
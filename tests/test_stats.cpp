@@ -0,0 +1,49 @@
+#include "scumECS/ECS.h"
+#include <typeinfo>
+#include <vector>
+
+struct HitEvent
+{
+	int damage;
+};
+
+template<>
+struct scum::Transient<HitEvent> : std::true_type
+{};
+
+int main()
+{
+	// stats report occupancy and high-water marks
+	{
+		scum::Manager manager;
+		std::vector<scum::ID> ids;
+		for(int i = 0; i < 1000; i++)
+		{
+			ids.push_back(manager.newID());
+		}
+		for(int i = 1; i < 1000; i += 2)
+		{
+			manager.add<HitEvent>(ids[i], i);
+		}
+		manager.processQueues();
+		auto stats = manager.stats();
+		size_t found = 0;
+		for(auto& pool : stats.pools)
+		{
+			if(pool.name == typeid(HitEvent).name())
+			{
+				found++;
+				if(pool.count != 0 || pool.peak != 500 || pool.capacity < 500 ||
+					pool.totalBytes == 0)
+				{
+					return -1;
+				}
+			}
+		}
+		if(found != 1 || stats.peakIDs != 1000 || stats.totalBytes == 0)
+		{
+			return -1;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,59 @@
+#include "scumECS/ECS.h"
+#include <vector>
+
+struct HitEvent
+{
+	int damage;
+};
+
+template<>
+struct scum::Transient<HitEvent> : std::true_type
+{};
+
+int main()
+{
+	scum::Manager manager;
+	std::vector<scum::ID> ids;
+	for(int i = 0; i < 1000; i++)
+	{
+		ids.push_back(manager.newID());
+	}
+
+	// transient components last until the next processQueues
+	for(int i = 1; i < 1000; i += 2)
+	{
+		manager.add<HitEvent>(ids[i], i);
+	}
+	manager.remove<HitEvent>(ids[1]);
+	manager.queueAdd<HitEvent>(ids[1], 5);
+	if(manager.contains<HitEvent>(ids[1]) ||
+		manager.get<HitEvent>(ids[3])->damage != 3)
+	{
+		return -1;
+	}
+	manager.processQueues();
+	auto& hits = manager.getPool<HitEvent>();
+	if(hits.size() != 1 || hits.get(ids[1])->damage != 5 ||
+		hits.tryGet(ids[3]) != nullptr)
+	{
+		return -1;
+	}
+	manager.processQueues();
+	if(hits.size() != 0 || hits.contains(ids[1]))
+	{
+		return -1;
+	}
+
+
+	// erasing IDs the index doesn't hold leaves it alone, even past its end
+	// or in a slot held by another ID
+	scum::EpochIndex index(std::pmr::get_default_resource());
+	index.set(ids[0], 7);
+	index.erase(ids[999]);
+	index.erase(ids[0] + 1);
+	if(index.find(ids[0]) != 7 || index.contains(ids[999]))
+	{
+		return -1;
+	}
+	return 0;
+}